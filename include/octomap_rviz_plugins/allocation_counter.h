@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef RVIZ_OCTOMAP_ALLOCATION_COUNTER_H
+#define RVIZ_OCTOMAP_ALLOCATION_COUNTER_H
+
+#include <stdint.h>
+#include <string>
+
+namespace octomap_rviz_plugin
+{
+
+// Per-thread counts of operator new calls and requested bytes. The counting
+// itself lives in liboctomap_rviz_alloc_hook, which replaces the global
+// operator new when it is loaded with LD_PRELOAD. Without it all counters
+// stay zero and available() returns false, so the hook costs nothing unless
+// it is asked for.
+class AllocationCounter
+{
+public:
+  struct Counts
+  {
+    Counts() : allocations(0), bytes(0) {}
+
+    uint64_t allocations;
+    uint64_t bytes;
+  };
+
+  static bool available();
+
+  // totals of the calling thread since it was started
+  static Counts current();
+
+  // human readable "N allocations (bytes)"
+  static std::string format(const Counts& counts);
+};
+
+// allocations of the calling thread while the scope is alive, accumulated
+// into counts
+class AllocationScope
+{
+public:
+  explicit AllocationScope(AllocationCounter::Counts& counts) :
+      counts_(counts),
+      begin_(AllocationCounter::current())
+  {
+  }
+
+  ~AllocationScope()
+  {
+    AllocationCounter::Counts end = AllocationCounter::current();
+    counts_.allocations += end.allocations - begin_.allocations;
+    counts_.bytes += end.bytes - begin_.bytes;
+  }
+
+private:
+  AllocationCounter::Counts& counts_;
+  AllocationCounter::Counts begin_;
+};
+
+} // namespace octomap_rviz_plugin
+
+#endif //RVIZ_OCTOMAP_ALLOCATION_COUNTER_H
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef RVIZ_OCTOMAP_ARENA_OCTREE_H
+#define RVIZ_OCTOMAP_ARENA_OCTREE_H
+
+#include <octomap/OcTreeKey.h>
+#include <octomap_msgs/Octomap.h>
+
+#include <stdint.h>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace octomap_rviz_plugin
+{
+
+// Read-only occupancy octree decoded straight from an octomap_msgs::Octomap.
+//
+// octomap::OcTree allocates every node and every child array on the heap,
+// which dominates decode and teardown time for large maps. This tree keeps
+// all nodes in a single arena; siblings are stored next to each other and
+// clear() only resets the arena, so after the first few messages decoding
+// does not allocate at all. Only the "OcTree" type is supported, in both the
+// binary and the full probability encoding.
+class ArenaOcTree
+{
+public:
+  typedef octomap::key_type key_type;
+
+  // summaries of a node's subtree, computed while decoding
+  enum NodeFlags
+  {
+    // the whole extent of the node is known (all children exist, recursively)
+    FLAG_COMPLETE = 1,
+    // complete and all leafs are free
+    FLAG_UNIFORM_FREE = 2,
+    // complete and all leafs are occupied
+    FLAG_UNIFORM_OCCUPIED = 4
+  };
+
+  struct Node
+  {
+    float log_odds;
+    // arena index of the first existing child, the others follow in child order
+    uint32_t first_child;
+    uint8_t child_mask;
+    uint8_t flags;
+
+    bool hasChildren() const { return child_mask != 0; }
+    bool childExists(unsigned int i) const { return child_mask & (1 << i); }
+    bool hasFlags(uint8_t f) const { return (flags & f) == f; }
+    float getLogOdds() const { return log_odds; }
+    double getOccupancy() const { return 1.0 - (1.0 / (1.0 + std::exp(log_odds))); }
+  };
+
+  // iterates over all leafs up to a maximum depth in depth first order.
+  // Children are visited in octomap child order, so nodes of the same depth
+  // come out sorted by the Morton code of their key. Inner nodes which have
+  // all of stop_flags set are returned instead of their children.
+  class iterator
+  {
+  public:
+    iterator();
+    iterator(const ArenaOcTree* tree, unsigned int max_depth, uint8_t stop_flags = 0);
+    // iterates over the subtree below the current node of parent
+    iterator(const iterator& parent, unsigned int max_depth, uint8_t stop_flags = 0);
+
+    bool operator==(const iterator& other) const;
+    bool operator!=(const iterator& other) const { return !(*this == other); }
+
+    iterator& operator++();
+
+    const Node& operator*() const { return *current().node; }
+    const Node* operator->() const { return current().node; }
+
+    const octomap::OcTreeKey& getKey() const { return current().key; }
+    octomap::OcTreeKey getIndexKey() const { return tree_->getIndexKey(current().key, current().depth); }
+    unsigned int getDepth() const { return current().depth; }
+    double getSize() const { return tree_->getNodeSize(current().depth); }
+    double getX() const { return tree_->keyToCoord(current().key[0], current().depth); }
+    double getY() const { return tree_->keyToCoord(current().key[1], current().depth); }
+    double getZ() const { return tree_->keyToCoord(current().key[2], current().depth); }
+
+  private:
+    struct StackEntry
+    {
+      const Node* node;
+      octomap::OcTreeKey key;
+      unsigned int depth;
+    };
+
+    const StackEntry& current() const { return stack_.back(); }
+
+    // expands inner nodes until a leaf or max_depth_ is on top of the stack
+    void descend();
+
+    const ArenaOcTree* tree_;
+    unsigned int max_depth_;
+    uint8_t stop_flags_;
+    std::vector<StackEntry> stack_;
+  };
+
+  ArenaOcTree();
+
+  // decodes the map contained in msg, returns false for unsupported or broken data
+  bool readMessage(const octomap_msgs::Octomap& msg);
+  bool readBinaryData(const char* data, std::size_t size, double resolution);
+  bool readFullData(const char* data, std::size_t size, double resolution);
+
+  // drops all nodes but keeps the arena allocated for the next map
+  void clear();
+  // releases the arena
+  void release();
+
+  bool empty() const { return nodes_.empty(); }
+  std::size_t size() const { return nodes_.size(); }
+  std::size_t getNumLeafNodes() const { return num_leafs_; }
+  std::size_t memoryUsage() const { return nodes_.capacity() * sizeof(Node); }
+
+  unsigned int getTreeDepth() const { return tree_depth_; }
+  double getResolution() const { return resolution_; }
+  double getNodeSize(unsigned int depth) const { return resolution_ * double(1 << (tree_depth_ - depth)); }
+
+  const Node* getRoot() const { return nodes_.empty() ? NULL : &nodes_[0]; }
+  octomap::OcTreeKey getRootKey() const;
+  const Node* getNodeChild(const Node* node, unsigned int i) const;
+
+  bool isNodeOccupied(const Node& node) const { return node.log_odds >= occupancy_thres_log_; }
+  bool isNodeOccupied(const Node* node) const { return isNodeOccupied(*node); }
+
+  // returns the deepest existing node containing key (up to depth, 0 = full
+  // depth) or NULL if the key lies in unknown space
+  const Node* search(const octomap::OcTreeKey& key, unsigned int depth = 0) const;
+
+  double keyToCoord(key_type key, unsigned int depth) const;
+  // minimum corner key of the node at key/depth
+  octomap::OcTreeKey getIndexKey(const octomap::OcTreeKey& key, unsigned int depth) const;
+  // key offset between the centers of a node at depth and its children
+  key_type getCenterOffsetKey(unsigned int depth) const { return tree_max_val_ >> (depth + 1); }
+  bool coordToKeyChecked(double coordinate, key_type& key) const;
+  octomap::OcTreeKey coordToKey(double x, double y, double z) const;
+
+  void getMetricMin(double& x, double& y, double& z) const;
+  void getMetricMax(double& x, double& y, double& z) const;
+
+  iterator begin(unsigned int max_depth = 0, uint8_t stop_flags = 0) const
+  {
+    return iterator(this, max_depth, stop_flags);
+  }
+  iterator beginSubtree(const iterator& parent, unsigned int max_depth = 0, uint8_t stop_flags = 0) const
+  {
+    return iterator(parent, max_depth, stop_flags);
+  }
+  iterator end() const { return iterator(); }
+
+  static unsigned int computeChildIdx(const octomap::OcTreeKey& key, int depth);
+  static void computeChildKey(unsigned int pos, key_type center_offset_key, const octomap::OcTreeKey& parent_key,
+                              octomap::OcTreeKey& child_key);
+
+protected:
+  // appends count nodes to the arena and returns the index of the first one
+  uint32_t allocateNodes(unsigned int count);
+
+  bool readBinaryNode(uint32_t index, unsigned int depth);
+  bool readFullNode(uint32_t index, unsigned int depth);
+
+  // sets the NodeFlags of the subtree at index, children first
+  uint8_t computeFlags(uint32_t index);
+
+  void computeMetricBounds();
+
+  std::vector<Node> nodes_;
+
+  // decoder input
+  const char* read_pos_;
+  const char* read_end_;
+
+  unsigned int tree_depth_;
+  key_type tree_max_val_;
+  double resolution_;
+
+  float occupancy_thres_log_;
+  float clamping_thres_min_;
+  float clamping_thres_max_;
+
+  std::size_t num_leafs_;
+  double metric_min_[3];
+  double metric_max_[3];
+};
+
+} // namespace octomap_rviz_plugin
+
+#endif //RVIZ_OCTOMAP_ARENA_OCTREE_H
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef RVIZ_OCTOMAP_CHUNKED_CLOUD_H
+#define RVIZ_OCTOMAP_CHUNKED_CLOUD_H
+
+#include "rviz/ogre_helpers/point_cloud.h"
+
+#include <stdint.h>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace Ogre {
+class SceneNode;
+}
+
+namespace octomap_rviz_plugin
+{
+
+// Equally sized voxels split into cubic chunks of the octree grid. Aligned
+// blocks of neighbouring chunks share one rviz::PointCloud, a batch, to keep
+// the number of renderables low. Batches keep their cloud from one update to
+// the next and are only uploaded again if their content changed, so a map
+// with small changes costs upload in proportion to the changed batches. A
+// few clouds of batches which ran empty are kept for reuse. Chunks can be
+// hidden individually, e.g. when they are occluded; a batch is hidden once
+// all of its chunks are.
+class ChunkedCloud
+{
+public:
+  typedef std::vector<rviz::PointCloud::Point> VPoint;
+
+  // chunk edge length in voxels
+  static const unsigned int CHUNK_VOXELS = 32;
+
+  // bounding box of the voxels of a chunk in the frame of the scene node
+  struct ChunkBox
+  {
+    float min[3];
+    float max[3];
+  };
+
+  ChunkedCloud(Ogre::SceneNode* node, const std::string& name);
+  ~ChunkedCloud();
+
+  void setRenderMode(rviz::PointCloud::RenderMode mode);
+  void setDimensions(float width, float height, float depth);
+
+  // replaces the content with points, which have to be sorted by the Morton
+  // code of the voxels on a grid of voxel_size, returns the number of points
+  // uploaded again
+  std::size_t update(VPoint& points, double voxel_size);
+
+  // appends points as a batch and chunk of their own, points may be in any
+  // order
+  void append(VPoint& points, double voxel_size);
+  // removes count points from the front, across chunks
+  void popFront(std::size_t count);
+  void clear();
+
+  std::size_t size() const { return size_; }
+  std::size_t chunkCount() const { return chunks_.size(); }
+  std::size_t batchCount() const { return batches_.size(); }
+
+  // changes with every change of the content, unique across all clouds
+  std::size_t generation() const { return generation_; }
+  // boxes of all chunks in chunk order
+  void getChunkBoxes(std::vector<ChunkBox>& boxes) const;
+
+  // hides the chunks whose entry in visible is zero, ignored if the content
+  // changed since generation, returns the number of chunks in hidden batches
+  std::size_t setChunkVisibility(std::size_t generation, const std::vector<uint8_t>& visible);
+  void showAllChunks();
+
+private:
+  struct Chunk
+  {
+    std::size_t points;
+    ChunkBox box;
+  };
+
+  struct Batch
+  {
+    // packed batch coordinates, unkeyed batches come from append()
+    uint64_t key;
+    bool keyed;
+    uint64_t hash;
+    std::size_t points;
+    std::size_t chunks;
+    rviz::PointCloud* cloud;
+    bool visible;
+  };
+
+  // splits the points of a batch into chunks and appends them to chunk_buf_,
+  // returns the number of chunks
+  std::size_t addChunks(const rviz::PointCloud::Point* points, std::size_t count, double voxel_size);
+  rviz::PointCloud* takeCloud();
+  void releaseCloud(rviz::PointCloud* cloud);
+  void computeBox(const rviz::PointCloud::Point* points, std::size_t count, double voxel_size, ChunkBox& box) const;
+
+  Ogre::SceneNode* node_;
+  std::string name_;
+  std::size_t next_cloud_id_;
+
+  rviz::PointCloud::RenderMode render_mode_;
+  float dimensions_[3];
+
+  // in Morton order after update(), in insertion order after append(); the
+  // chunks of a batch follow each other
+  std::deque<Batch> batches_;
+  std::deque<Batch> batch_buf_;
+  std::deque<Chunk> chunks_;
+  std::deque<Chunk> chunk_buf_;
+  std::vector<rviz::PointCloud*> free_clouds_;
+  std::size_t size_;
+  std::size_t generation_;
+};
+
+} // namespace octomap_rviz_plugin
+
+#endif //RVIZ_OCTOMAP_CHUNKED_CLOUD_H
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef RVIZ_OCTOMAP_DISTANCE_TRANSFORM_H
+#define RVIZ_OCTOMAP_DISTANCE_TRANSFORM_H
+
+#include <nav_msgs/OccupancyGrid.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "octomap_rviz_plugins/worker_pool.h"
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+namespace octomap_rviz_plugin
+{
+
+// Euclidean distance of every cell of an occupancy grid to the nearest
+// occupied one, capped at a maximum distance. Computed with the separable
+// linear-time algorithm of Felzenszwalb and Huttenlocher: a pass along the
+// columns, then the lower envelope of parabolas along the rows. Both passes
+// are split into line ranges which run on the shared worker pool. If only
+// some cells changed since the last grid, only the columns containing them
+// and the rows within the maximum distance are recomputed.
+class DistanceTransform : boost::noncopyable
+{
+public:
+  DistanceTransform();
+
+  // brings the distances up to date with grid, returns the number of cells
+  // recomputed
+  std::size_t update(const nav_msgs::OccupancyGrid& grid, double max_distance);
+
+  // forgets the last grid, the next update recomputes all cells
+  void clear();
+
+  // in meters, per cell of the last grid
+  const std::vector<float>& distances() const { return distances_; }
+
+  std::size_t memoryUsage() const;
+
+  // cells with at least this value are obstacles, like octomap's default
+  // occupancy threshold of 0.5
+  static const int8_t OCCUPIED_VALUE = 50;
+
+protected:
+  typedef void (DistanceTransform::*Pass)(int begin, int end);
+
+  // squared distances to the nearest obstacle within the columns
+  // [begin, end]
+  void transformColumns(int begin, int end);
+  // distances of the rows [begin, end] within the dirty window
+  void transformRows(int begin, int end);
+
+  // runs pass on ranges of the lines [begin, end], the calling thread takes
+  // part so the call finishes even if all workers are busy
+  void runParallel(Pass pass, int begin, int end);
+  void work();
+
+  // last grid
+  unsigned int width_;
+  unsigned int height_;
+  float resolution_;
+  double origin_x_;
+  double origin_y_;
+  double max_distance_;
+  std::vector<uint8_t> obstacles_;
+
+  std::vector<float> column_distances_;
+  std::vector<float> distances_;
+
+  // columns written by transformRows and the columns their values depend on
+  int dirty_min_x_;
+  int dirty_max_x_;
+  int window_min_x_;
+  int window_max_x_;
+
+  // the running runParallel() call, guarded by job_mutex_
+  boost::mutex job_mutex_;
+  boost::condition_variable job_done_;
+  Pass job_pass_;
+  int job_next_;
+  int job_end_;
+  int job_chunk_;
+  int job_running_;
+
+  // destroyed first, which waits for running helpers
+  enum { MAX_HELPERS = 8 };
+  WorkerPool::Queue helper_queues_[MAX_HELPERS];
+};
+
+} // namespace octomap_rviz_plugin
+
+#endif //RVIZ_OCTOMAP_DISTANCE_TRANSFORM_H
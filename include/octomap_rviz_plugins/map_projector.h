@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Author: Julius Kammerl (jkammerl@willowgarage.com)
+ *
+ */
+
+#ifndef RVIZ_OCTOMAP_MAP_PROJECTOR_H
+#define RVIZ_OCTOMAP_MAP_PROJECTOR_H
+
+#include <nav_msgs/OccupancyGrid.h>
+
+#include "octomap_rviz_plugins/arena_octree.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace octomap_rviz_plugin
+{
+
+// Projects an ArenaOcTree onto the XY plane. A cell is occupied (100) if any
+// voxel above it is occupied, free (0) if only free voxels were seen and
+// unknown (-1) otherwise. Like VoxelExtractor it has no display state and is
+// shared between OccupancyMapDisplay and the replay benchmark.
+class MapProjector
+{
+public:
+  // heights [min_z, max_z) of a band projected into a grid of its own
+  struct ZBand
+  {
+    double min_z;
+    double max_z;
+  };
+
+  enum { MAX_Z_BANDS = 32 };
+
+  // top of the highest occupied voxel above every cell of a grid, NaN where
+  // there is none
+  struct HeightMap
+  {
+    nav_msgs::MapMetaData info;
+    std::vector<float> heights;
+  };
+
+  // largest depth not above max_depth whose grid fits into memory_limit bytes
+  // next to fixed_bytes, 0 disables the limit. The map display keeps the grid
+  // and a texture copy, band grids add one more byte per cell each. A
+  // window_size above 0 sizes the grid like projectWindow instead of by the
+  // map's bounds.
+  static unsigned int fitDepth(const ArenaOcTree& octree, unsigned int max_depth, std::size_t fixed_bytes,
+                               std::size_t memory_limit, std::size_t bytes_per_cell = 2, double window_size = 0.0);
+
+  // fills everything but the header of grid with the projection at depth
+  static void project(const ArenaOcTree& octree, unsigned int depth, nav_msgs::OccupancyGrid& grid);
+
+  // like project, but descends only into subtrees which are neither
+  // uniformly free nor uniformly occupied and fills the footprint of the
+  // others in one step, so the cost follows the map's complexity rather
+  // than its leaf count. With probability set, cells hold the highest
+  // occupancy above them in percent instead of 100 and 0; uniform subtrees
+  // use the maximum stored in their root.
+  static void projectSummaries(const ArenaOcTree& octree, unsigned int depth, bool probability,
+                               nav_msgs::OccupancyGrid& grid);
+
+  // projectSummaries into one grid per band in a single traversal, voxels
+  // count for every band they overlap and subtrees outside of all bands are
+  // skipped. Bands beyond MAX_Z_BANDS or without a grid are ignored.
+  static void projectBands(const ArenaOcTree& octree, unsigned int depth, bool probability,
+                           const std::vector<ZBand>& bands, const std::vector<nav_msgs::OccupancyGrid*>& grids);
+
+  // projectBands restricted to a square window of size meters around
+  // center_x/center_y, aligned to the cells at depth, so only subtrees
+  // intersecting it are visited. With shift set, grids which still hold a
+  // window of the same geometry projected from the same tree keep the cells
+  // both windows share and only the newly exposed strips are projected.
+  // Returns the number of cells projected.
+  static std::size_t projectWindow(const ArenaOcTree& octree, unsigned int depth, bool probability,
+                                   const std::vector<ZBand>& bands, const std::vector<nav_msgs::OccupancyGrid*>& grids,
+                                   double center_x, double center_y, double size, bool shift);
+
+  // fills map with the geometry of a grid at depth and the height of every
+  // column. Only occupied subtrees are visited, upper children before lower
+  // ones, and subtrees which cannot reach above the columns they cover are
+  // skipped, so mostly the highest nodes are touched.
+  static void projectHeights(const ArenaOcTree& octree, unsigned int depth, HeightMap& map);
+
+protected:
+  // sets up the grid geometry for depth with all cells unknown, returns the
+  // key of the first cell
+  static octomap::OcTreeKey initGrid(const ArenaOcTree& octree, unsigned int depth, nav_msgs::OccupancyGrid& grid);
+  // like initGrid, but only sets up info
+  static octomap::OcTreeKey initGridInfo(const ArenaOcTree& octree, unsigned int depth, nav_msgs::MapMetaData& info);
+};
+
+} // namespace octomap_rviz_plugin
+
+#endif //RVIZ_OCTOMAP_MAP_PROJECTOR_H
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef RVIZ_OCTOMAP_MEMORY_ACCOUNTING_H
+#define RVIZ_OCTOMAP_MEMORY_ACCOUNTING_H
+
+#include <boost/thread/mutex.hpp>
+
+#include <cstddef>
+#include <string>
+
+namespace octomap_rviz_plugin
+{
+
+// Tracks the memory held by a display, split up by category. Values are set
+// (not accumulated) whenever the owner knows the size of a buffer, the peak
+// values are kept until reset() is called.
+class MemoryAccounting
+{
+public:
+  enum Category
+  {
+    OCTREE,
+    POINT_BUFFERS,
+    RENDER_BUFFERS,
+    MESSAGE_QUEUE,
+    OCCUPANCY_GRID,
+    NUM_CATEGORIES
+  };
+
+  MemoryAccounting();
+
+  void set(Category category, std::size_t bytes);
+  void reset();
+
+  std::size_t current(Category category) const;
+  std::size_t peak(Category category) const;
+  std::size_t total() const;
+  std::size_t peakTotal() const;
+
+  // human readable "current (peak)" summary of all non-empty categories
+  std::string summary() const;
+
+  static const char* categoryName(Category category);
+  static std::string formatBytes(std::size_t bytes);
+
+private:
+  mutable boost::mutex mutex_;
+
+  std::size_t current_[NUM_CATEGORIES];
+  std::size_t peak_[NUM_CATEGORIES];
+  std::size_t peak_total_;
+};
+
+} // namespace octomap_rviz_plugin
+
+#endif //RVIZ_OCTOMAP_MEMORY_ACCOUNTING_H
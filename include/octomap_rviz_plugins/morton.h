@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef RVIZ_OCTOMAP_MORTON_H
+#define RVIZ_OCTOMAP_MORTON_H
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+namespace octomap_rviz_plugin
+{
+
+// spreads the lower 16 bits of v so that two zero bits follow every bit
+inline uint64_t mortonSpread(uint64_t v)
+{
+  v &= 0xffff;
+  v = (v | (v << 16)) & 0x0000ff0000ffULL;
+  v = (v | (v << 8))  & 0x00f00f00f00fULL;
+  v = (v | (v << 4))  & 0x0c30c30c30c3ULL;
+  v = (v | (v << 2))  & 0x249249249249ULL;
+  return v;
+}
+
+inline uint16_t mortonCompact(uint64_t v)
+{
+  v &= 0x249249249249ULL;
+  v = (v | (v >> 2))  & 0x0c30c30c30c3ULL;
+  v = (v | (v >> 4))  & 0x00f00f00f00fULL;
+  v = (v | (v >> 8))  & 0x0000ff0000ffULL;
+  v = (v | (v >> 16)) & 0xffff;
+  return static_cast<uint16_t>(v);
+}
+
+// Z-order code of a 16 bit octree key, x occupies the least significant bit.
+// Voxels of any depth are encoded by their minimum corner (index key), so all
+// voxels inside a subtree form one contiguous code range.
+inline uint64_t mortonEncode(uint16_t x, uint16_t y, uint16_t z)
+{
+  return mortonSpread(x) | (mortonSpread(y) << 1) | (mortonSpread(z) << 2);
+}
+
+inline void mortonDecode(uint64_t code, uint16_t& x, uint16_t& y, uint16_t& z)
+{
+  x = mortonCompact(code);
+  y = mortonCompact(code >> 1);
+  z = mortonCompact(code >> 2);
+}
+
+namespace detail
+{
+
+static const unsigned int radix_bits = 8;
+static const unsigned int radix_buckets = 1 << radix_bits;
+static const unsigned int morton_bits = 48;
+
+} // namespace detail
+
+// Stable LSD radix sort of records by their 48 bit Morton "code" member,
+// passes in which all records share the same digit are skipped. scratch is
+// resized as needed and can be reused. Runs on the calling thread, callers
+// are worker pool tasks which already run concurrently.
+template <typename Record>
+void mortonRadixSort(std::vector<Record>& records, std::vector<Record>& scratch)
+{
+  const std::size_t size = records.size();
+  if (size < 2)
+    return;
+
+  // depth first octree traversals already produce Z-order
+  bool sorted = true;
+  for (std::size_t i = 1; sorted && i < size; ++i)
+    sorted = records[i - 1].code <= records[i].code;
+  if (sorted)
+    return;
+
+  scratch.resize(size);
+
+  std::size_t offsets[detail::radix_buckets];
+  Record* in = &records[0];
+  Record* out = &scratch[0];
+
+  for (unsigned int shift = 0; shift < detail::morton_bits; shift += detail::radix_bits)
+  {
+    std::fill(offsets, offsets + detail::radix_buckets, 0);
+    for (const Record* r = in; r != in + size; ++r)
+      ++offsets[(r->code >> shift) & (detail::radix_buckets - 1)];
+
+    // turn the histogram into scatter offsets
+    std::size_t offset = 0;
+    bool single_bucket = false;
+    for (unsigned int b = 0; b < detail::radix_buckets; ++b)
+    {
+      std::size_t count = offsets[b];
+      offsets[b] = offset;
+      offset += count;
+      if (count == size)
+        single_bucket = true;
+    }
+
+    if (single_bucket)
+      continue;
+
+    for (const Record* r = in; r != in + size; ++r)
+      out[offsets[(r->code >> shift) & (detail::radix_buckets - 1)]++] = *r;
+
+    std::swap(in, out);
+  }
+
+  if (in != &records[0])
+    records.swap(scratch);
+}
+
+} // namespace octomap_rviz_plugin
+
+#endif //RVIZ_OCTOMAP_MORTON_H
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef RVIZ_OCTOMAP_OCCLUSION_CULLER_H
+#define RVIZ_OCTOMAP_OCCLUSION_CULLER_H
+
+#include <cstddef>
+#include <vector>
+
+namespace octomap_rviz_plugin
+{
+
+// Decides which boxes may be visible from a camera. Occluders are cubes which
+// are drawn as solid boxes; they are rasterized into a small depth buffer in
+// which a texel only takes the depth of an occluder covering it completely.
+// A box is hidden only if every texel its projection touches holds an
+// occluder in front of it, so the test errs towards showing boxes. Boxes
+// reaching behind the eye or out of the field of view are always visible,
+// which keeps a hidden box hidden whichever way the camera turns.
+class OcclusionCuller
+{
+public:
+  // camera in the map frame, the axes are unit vectors
+  struct View
+  {
+    double eye[3];
+    double right[3];
+    double up[3];
+    double forward[3];
+    // tangents of half the horizontal and vertical field of view
+    double tan_half_fov[2];
+    // the camera clips voxels nearer than near_clip or farther than far_clip,
+    // a far_clip of 0 is infinite
+    double near_clip;
+    double far_clip;
+  };
+
+  // width of the depth buffer in texels, its height follows the aspect ratio
+  explicit OcclusionCuller(std::size_t width = 256);
+
+  // starts a pass for view with an empty depth buffer
+  void setView(const View& view);
+  // rasterizes the cube of edge length size around center
+  void addOccluder(const double center[3], double size);
+  // builds the depth hierarchy, has to be called after the last occluder
+  void finishOccluders();
+
+  bool isBoxVisible(const double min[3], const double max[3]) const;
+
+protected:
+  // coordinates of point along right, up and forward relative to the eye
+  void toView(const double point[3], double view[3]) const;
+  // view distance at which the ray through the texel corner (u, v) enters
+  // the box, infinity if it misses
+  double rayEntry(std::size_t u, std::size_t v, const double min[3], const double max[3]) const;
+  // true if a texel of level 0 within range = {x0, y0, x1, y1} below the
+  // texel (x, y) of level lacks an occluder in front of depth
+  bool isRangeVisible(std::size_t level, std::size_t x, std::size_t y, const std::size_t range[4],
+                      double depth) const;
+
+  View view_;
+  std::size_t width_;
+  std::size_t height_;
+  // occluder depth per texel, level 0 is the depth buffer and every further
+  // level holds the maximum of 2x2 texels of the one below
+  std::vector<std::vector<double> > depth_;
+  std::vector<std::size_t> level_width_;
+  std::vector<std::size_t> level_height_;
+  // ray entries at the texel corners covered by an occluder
+  std::vector<double> corner_entry_;
+};
+
+} // namespace octomap_rviz_plugin
+
+#endif //RVIZ_OCTOMAP_OCCLUSION_CULLER_H
@@ -41,17 +41,40 @@
 
 #include <message_filters/subscriber.h>
 
+#include <deque>
+
 #include <octomap_msgs/Octomap.h>
 
+#include <OGRE/OgreVector3.h>
+#include <OGRE/OgreQuaternion.h>
+
 #include <rviz/display.h>
 #include "rviz/ogre_helpers/point_cloud.h"
 
+#include "octomap_rviz_plugins/arena_octree.h"
+#include "octomap_rviz_plugins/chunked_cloud.h"
+#include "octomap_rviz_plugins/memory_accounting.h"
+#include "octomap_rviz_plugins/occlusion_culler.h"
+#include "octomap_rviz_plugins/recording.h"
+#include "octomap_rviz_plugins/voxel_extractor.h"
+#include "octomap_rviz_plugins/worker_pool.h"
+#include "octomap_rviz_plugins/z_layer_index.h"
+
 #endif
 
+namespace Ogre {
+class SceneNode;
+class Camera;
+}
+
 namespace rviz {
 class RosTopicProperty;
 class IntProperty;
+class BoolProperty;
+class FloatProperty;
 class EnumProperty;
+class StringProperty;
+class TfFrameProperty;
 }
 
 namespace octomap_rviz_plugin
@@ -75,6 +98,15 @@ private Q_SLOTS:
   void updateTreeDepth();
   void updateOctreeRenderMode();
   void updateOctreeColorMode();
+  void updateMemoryLimit();
+  void updateRecordFile();
+  void updateSlice();
+  void updateRenderStyle();
+  void updateTransformTime();
+  void updateWorkerThreads();
+  void updateVoxelBudget();
+  void updateMergeTolerance();
+  void updateOcclusionCulling();
 
 
 protected:
@@ -85,34 +117,265 @@ protected:
   void subscribe();
   void unsubscribe();
 
+  // queues msg for the shared worker pool
   void incomingMessageCallback(const octomap_msgs::OctomapConstPtr& msg);
 
-  void setColor( double z_pos, double min_z, double max_z, double color_factor, rviz::PointCloud::Point& point);
+  // worker pool task, processes the oldest pending message
+  void processPendingMessage();
+  void processMessage(const octomap_msgs::OctomapConstPtr& msg);
+  void updateQueueStatus();
 
-  void clear();
+  // looks up the pose of a frame at the time selected by the transform time
+  // policy
+  bool getFrameTransform(const std::string& frame_id, const ros::Time& stamp, Ogre::Vector3& position,
+                       Ogre::Quaternion& orientation);
+
+  // moves the scene node to the current pose of the last map, called every
+  // frame with mutex_ held
+  void updateMapTransform();
+
+  typedef VoxelExtractor::VoxelSet VoxelSet;
+  enum { NUM_VOXEL_SETS = VoxelExtractor::NUM_VOXEL_SETS };
+  typedef VoxelExtractor::VPoint VPoint;
+  typedef VoxelExtractor::VVPoint VVPoint;
+
+  // extracts one voxel set of octree_ and hands it over to the render thread,
+  // the caller has to hold octree_mutex_
+  void extractVoxelSet(VoxelSet set);
+  // hands over an empty set in place of the geometry of the previous map,
+  // the caller has to hold octree_mutex_
+  void dropVoxelSet(VoxelSet set);
+
+  // hands over a preview up to coarse_depth, then refines it region by region
+  // up to tree_depth while collecting the full result in point_buf_, returns
+  // false if more than max_points voxels are visible
+  bool extractProgressively(VoxelSet set, unsigned int coarse_depth, unsigned int tree_depth,
+                            std::size_t max_points, std::size_t& point_count);
+
+  // worker pool task, extracts the shown sets of the retained map again
+  void reextractVoxelSets();
+
+  // worker pool task, lazily extracts the shown sets which were hidden when
+  // the map arrived
+  void extractMissingVoxelSets();
+
+  // moves focus_ to the origin of the focus frame, the caller has to hold
+  // octree_mutex_
+  void updateFocus(const std::string& map_frame, const ros::Time& stamp);
+
+  void updateVoxelSetVisibility();
+
+  // appends msg and the current view to the recording file, if one is open
+  void recordMessage(const octomap_msgs::Octomap& msg, const Ogre::Vector3& map_position,
+                     const Ogre::Quaternion& map_orientation);
+
+  // the caller has to hold octree_mutex_
+  void updatePointBufferMemory();
+  void updateMemoryStatus();
+
+  // chunked clouds of a set and depth are created on first use and released
+  // when the depth runs empty, the caller has to hold mutex_
+  void createCloud(int set, std::size_t depth_index);
+  void destroyCloud(int set, std::size_t depth_index);
+  void updateBatchStatus();
+
+  // the shown voxels of a set and depth, restricted to the slice if enabled
+  VPoint& visiblePoints(int set, std::size_t depth_index);
+
+  // selects the slice of a set and records the extent of every depth, the
+  // caller has to hold mutex_
+  void selectVoxels(int set);
+
+  // picks the render style of every cloud, in "Auto" mode from the projected
+  // voxel size and the vertex budget, returns whether a style changed
+  bool updateRenderStyles(const Ogre::Camera* camera);
 
-  typedef std::vector<rviz::PointCloud::Point> VPoint;
-  typedef std::vector<VPoint> VVPoint;
+  // position of the camera in the map frame
+  Ogre::Vector3 getMapFrameEye(const Ogre::Camera* camera);
+
+  // applies finished occlusion results and queues a new pass once the view
+  // or the clouds changed, the caller has to hold mutex_
+  void updateOcclusion(const Ogre::Camera* camera);
+  // fills the generation and style of every cloud and the render mode, the
+  // caller has to hold mutex_
+  void getOcclusionState(std::vector<std::size_t>& state);
+  // distance the eye may move before the results of a pass no longer apply
+  double getOcclusionTolerance();
+  void showAllChunks();
+
+  // worker pool task, tests the queued chunk boxes against the queued
+  // occluders
+  void cullOccludedChunks();
+
+  // uploads the changed chunks and returns their number of voxels, the
+  // caller has to hold mutex_
+  std::size_t uploadCloud(int set, std::size_t depth_index);
+  void applyCloudStyle(int set, std::size_t depth_index);
+  void updateRenderMemory();
+  void growCloudExtent(int set, std::size_t depth_index, const VPoint& points);
+
+  // applies the queued progressive refinement steps, the caller has to hold
+  // mutex_
+  void applyRefinementSteps();
+
+  void clear();
 
   boost::shared_ptr<message_filters::Subscriber<octomap_msgs::Octomap> > sub_;
 
+  // messages waiting for the worker pool, at most queue_size_ of them
+  boost::mutex pending_mutex_;
+  std::deque<octomap_msgs::OctomapConstPtr> pending_messages_;
+  WorkerPool::Queue work_queue_;
+
   boost::mutex mutex_;
 
+  // last decoded map, kept to extract voxel sets on demand
+  boost::mutex octree_mutex_;
+  ArenaOcTree octree_;
+  bool voxel_set_extracted_[NUM_VOXEL_SETS];
+  // bytes the buffers of an extracted set count against the memory limit
+  std::size_t voxel_set_bytes_[NUM_VOXEL_SETS];
+  // origin of the focus frame in the map frame
+  double focus_[3];
+
+  VoxelExtractor extractor_;
+
+  // centers of the occupied voxels per depth, built along with the point
+  // buffers so occlusion passes share them instead of copying shown points
+  typedef std::vector<std::vector<Ogre::Vector3> > VVCenter;
+  typedef boost::shared_ptr<const VVCenter> VVCenterConstPtr;
+
   // point buffer
-  VVPoint new_points_;
-  VVPoint point_buf_;
-  bool new_points_received_;
+  VVPoint new_points_[NUM_VOXEL_SETS];
+  VVCenterConstPtr new_centers_;
+  VVPoint point_buf_[NUM_VOXEL_SETS];
+  bool new_points_received_[NUM_VOXEL_SETS];
 
-  // Ogre-rviz point clouds
-  std::vector<rviz::PointCloud*> cloud_;
+  // Progressive updates: coarse voxels of a region are popped from the front
+  // of the clouds, which works because both preview and regions are in
+  // Morton order, and the region's voxels are appended.
+  struct RefinementStep
+  {
+    int set;
+    // the clouds are emptied first
+    bool replace;
+    // points to pop per depth
+    std::vector<std::size_t> pop;
+    VVPoint points;
+  };
+  std::deque<RefinementStep> refinement_steps_;
+  // the clouds already hold the new points through refinement steps
+  bool progressive_uploaded_[NUM_VOXEL_SETS];
+  VVPoint coarse_points_;
+  VVPoint region_points_;
+
+  // Z layer index per set and depth, built along with the point buffers
+  std::vector<ZLayerIndex> new_layers_[NUM_VOXEL_SETS];
+  std::vector<ZLayerIndex> layer_buf_[NUM_VOXEL_SETS];
+
+  // voxels of the last uploaded map, kept by the render thread so that slices
+  // can be reselected without extracting the map again
+  VVPoint shown_points_[NUM_VOXEL_SETS];
+  VVCenterConstPtr shown_centers_;
+  std::vector<ZLayerIndex> shown_layers_[NUM_VOXEL_SETS];
+  VVPoint slice_points_[NUM_VOXEL_SETS];
+  bool slice_changed_;
+
+  // Ogre-rviz point clouds, one scene node per voxel set
+  Ogre::SceneNode* voxel_set_node_[NUM_VOXEL_SETS];
+  std::vector<ChunkedCloud*> cloud_[NUM_VOXEL_SETS];
   std::vector<double> box_size_;
 
+  // uploaded voxels of a cloud and their bounding box in the map frame
+  struct CloudExtent
+  {
+    std::size_t points;
+    Ogre::Vector3 min;
+    Ogre::Vector3 max;
+  };
+  std::vector<CloudExtent> cloud_extent_[NUM_VOXEL_SETS];
+  // rviz::PointCloud::RenderMode chosen for a cloud and the one it uses
+  std::vector<int> cloud_style_[NUM_VOXEL_SETS];
+  std::vector<int> applied_style_[NUM_VOXEL_SETS];
+  bool render_style_changed_;
+
+  // Occlusion culling: the render thread queues the camera, the chunk boxes
+  // of every cloud and the depths of the occupied voxels drawn as boxes, a
+  // worker pool task tests the boxes against the shared centers of these
+  // voxels and hands back which chunks to show. Results only apply while the
+  // clouds stay as they were and the eye stays within the tolerance of where
+  // the pass was queued, otherwise all chunks are shown until the next pass.
+  // Guarded by mutex_.
+  struct OcclusionQuery
+  {
+    int set;
+    std::size_t depth_index;
+    std::size_t generation;
+    std::vector<ChunkedCloud::ChunkBox> boxes;
+    std::vector<uint8_t> visible;
+  };
+  struct OccluderLayer
+  {
+    std::size_t depth_index;
+    double size;
+  };
+  std::vector<OcclusionQuery> occlusion_queries_;
+  std::vector<OccluderLayer> occlusion_occluders_;
+  VVCenterConstPtr occlusion_centers_;
+  // only voxels within the slab are drawn while slicing
+  bool occlusion_slice_;
+  double occlusion_slice_min_;
+  double occlusion_slice_max_;
+  double occlusion_tolerance_;
+  OcclusionCuller::View occlusion_view_;
+  // view of the pass whose results hide chunks
+  OcclusionCuller::View occlusion_applied_view_;
+  // generation and style of every cloud and the render mode of the queued pass
+  std::vector<std::size_t> occlusion_state_;
+  bool occlusion_pending_;
+  bool occlusion_ready_;
+  bool occlusion_active_;
+  // chunks are hidden by the results of the last pass
+  bool occlusion_hiding_;
+  // the clouds of a set are being refined and differ from its shown points
+  bool refining_[NUM_VOXEL_SETS];
+
   // Plugin properties
   rviz::IntProperty* queue_size_property_;
   rviz::RosTopicProperty* octomap_topic_property_;
   rviz::EnumProperty* octree_render_property_;
   rviz::EnumProperty* octree_coloring_property_;
   rviz::IntProperty* tree_depth_property_;
+  rviz::IntProperty* memory_limit_property_;
+  rviz::StringProperty* record_file_property_;
+  rviz::IntProperty* worker_threads_property_;
+  rviz::IntProperty* max_voxels_property_;
+  rviz::FloatProperty* merge_tolerance_property_;
+  rviz::IntProperty* progressive_depth_property_;
+  rviz::TfFrameProperty* focus_frame_property_;
+  rviz::EnumProperty* transform_time_property_;
+  rviz::EnumProperty* render_style_property_;
+  rviz::IntProperty* vertex_budget_property_;
+  rviz::BoolProperty* slice_property_;
+  rviz::BoolProperty* occlusion_property_;
+  rviz::FloatProperty* slice_height_property_;
+  rviz::FloatProperty* slice_thickness_property_;
+
+  MemoryAccounting memory_;
+
+  // message recording for the replay benchmark
+  boost::mutex record_mutex_;
+  RecordingWriter recorder_;
+  ros::WallTime record_start_;
+
+  // frame and stamp of the last map, guarded by mutex_
+  std::string map_frame_;
+  ros::Time map_stamp_;
+  bool transform_ok_;
+
+  // camera pose of the last rendered frame, guarded by mutex_
+  Ogre::Vector3 camera_position_;
+  Ogre::Quaternion camera_orientation_;
 
   u_int32_t queue_size_;
   std::size_t octree_depth_;
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef RVIZ_OCCUPANCY_HEIGHT_MAP_DISPLAY_H
+#define RVIZ_OCCUPANCY_HEIGHT_MAP_DISPLAY_H
+
+#ifndef Q_MOC_RUN
+#include <ros/ros.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <message_filters/subscriber.h>
+
+#include <octomap_msgs/Octomap.h>
+
+#include <OGRE/OgreColourValue.h>
+#include <OGRE/OgreVector3.h>
+
+#include <rviz/display.h>
+
+#include "octomap_rviz_plugins/arena_octree.h"
+#include "octomap_rviz_plugins/map_projector.h"
+#include "octomap_rviz_plugins/memory_accounting.h"
+#include "octomap_rviz_plugins/worker_pool.h"
+
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#endif
+
+namespace Ogre {
+class ManualObject;
+}
+
+namespace rviz {
+class RosTopicProperty;
+class IntProperty;
+class FloatProperty;
+}
+
+namespace octomap_rviz_plugin
+{
+
+// Shows the top of the occupied space as one colored triangle mesh with a
+// vertex per grid cell, which is far cheaper than the voxels below it for
+// terrain.
+class OccupancyHeightMapDisplay : public rviz::Display
+{
+Q_OBJECT
+public:
+  OccupancyHeightMapDisplay();
+  virtual ~OccupancyHeightMapDisplay();
+
+  // Overrides from Display
+  virtual void onInitialize();
+  virtual void update(float wall_dt, float ros_dt);
+  virtual void reset();
+
+private Q_SLOTS:
+  void updateTopic();
+  void updateTreeDepth();
+  void updateColorFactor();
+
+protected:
+  // overrides from Display
+  virtual void onEnable();
+  virtual void onDisable();
+
+  void subscribe();
+  void unsubscribe();
+
+  // queues msg for the shared worker pool
+  void incomingMessageCallback(const octomap_msgs::OctomapConstPtr& msg);
+
+  // worker pool task, processes the oldest pending message
+  void processPendingMessage();
+  void processMessage(const octomap_msgs::OctomapConstPtr& msg);
+  void updateQueueStatus();
+
+  // worker pool task, projects the retained octree at the current depth
+  void reprojectHeights();
+  void projectHeights();
+
+  // worker pool task, triangulates heights_ and hands the mesh over to the
+  // render thread
+  void buildMesh();
+
+  // moves the scene node to the pose of the last map, the caller has to hold
+  // mutex_
+  void updateMapTransform();
+
+  void clear();
+
+  struct Mesh
+  {
+    std::vector<Ogre::Vector3> positions;
+    std::vector<Ogre::ColourValue> colors;
+    // three per triangle
+    std::vector<uint32_t> indices;
+  };
+
+  boost::shared_ptr<message_filters::Subscriber<octomap_msgs::Octomap> > sub_;
+
+  // messages waiting for the worker pool
+  boost::mutex pending_mutex_;
+  std::deque<octomap_msgs::OctomapConstPtr> pending_messages_;
+  WorkerPool::Queue work_queue_;
+
+  // the last decoded map and its heights, only accessed by pool tasks
+  ArenaOcTree octree_;
+  MapProjector::HeightMap heights_;
+
+  // mesh waiting for the render thread and the frame and stamp of its map,
+  // guarded by mutex_
+  boost::mutex mutex_;
+  Mesh new_mesh_;
+  bool new_mesh_received_;
+  std::string map_frame_;
+  ros::Time map_stamp_;
+  bool transform_ok_;
+
+  Ogre::ManualObject* manual_object_;
+
+  // Plugin properties
+  rviz::RosTopicProperty* octomap_topic_property_;
+  rviz::IntProperty* tree_depth_property_;
+  rviz::FloatProperty* color_factor_property_;
+
+  MemoryAccounting memory_;
+
+  uint32_t messages_received_;
+};
+
+} // namespace octomap_rviz_plugin
+
+#endif //RVIZ_OCCUPANCY_HEIGHT_MAP_DISPLAY_H
@@ -40,13 +40,38 @@
 #include <ros/ros.h>
 
 #include "rviz/default_plugin/map_display.h"
+#include "rviz/ogre_helpers/point_cloud.h"
 
 #include <octomap_msgs/Octomap.h>
 
 #include <message_filters/subscriber.h>
 
+#include "octomap_rviz_plugins/allocation_counter.h"
+#include "octomap_rviz_plugins/arena_octree.h"
+#include "octomap_rviz_plugins/distance_transform.h"
+#include "octomap_rviz_plugins/map_projector.h"
+#include "octomap_rviz_plugins/memory_accounting.h"
+#include "octomap_rviz_plugins/worker_pool.h"
+
+#include <boost/thread/mutex.hpp>
+
+#include <deque>
+#include <vector>
+
 #endif
 
+namespace Ogre {
+class SceneNode;
+}
+
+namespace rviz {
+class BoolProperty;
+class EnumProperty;
+class FloatProperty;
+class StringProperty;
+class TfFrameProperty;
+}
+
 namespace octomap_rviz_plugin
 {
 
@@ -60,18 +85,110 @@ public:
 private Q_SLOTS:
   void updateTopic();
   void updateTreeDepth();
+  void updateMemoryLimit();
+  void updateProjection();
+  void updateWorkerThreads();
+  void updateZBands();
+  void updateBandVisibility();
 
 protected:
   virtual void onInitialize();
   virtual void subscribe();
   virtual void unsubscribe();
+  virtual void update(float wall_dt, float ros_dt);
 
+  // queues msg for the shared worker pool
   void handleOctomapBinaryMessage(const octomap_msgs::OctomapConstPtr& msg);
 
+  // worker pool task, projects the oldest pending message
+  void processPendingMessage();
+  void processMessage(const octomap_msgs::OctomapConstPtr& msg);
+  // worker pool task, projects the retained octree with the current settings
+  void reprojectMap();
+  // worker pool task, moves the rolling window to window_center_
+  void shiftWindow();
+  // projects octree_ and hands the grid to the map display. With
+  // shift_window only the strips the window moved onto are projected.
+  void projectMap(bool shift_window = false);
+  // looks up the window frame in the map frame and moves the window once it
+  // left the current cell
+  void updateWindowCenter();
+  void updateQueueStatus();
+
+  // worker pool task, shows the bands of the last map selected by
+  // shown_bands_
+  void showBands();
+  // the maximum of the shown band grids
+  void blendBands(const std::vector<bool>& shown, nav_msgs::OccupancyGrid& grid) const;
+  // shades the free cells of grid near obstacles in the clearance overlay if
+  // clearance is enabled, returns the number of shaded cells
+  std::size_t updateClearance(const nav_msgs::OccupancyGrid& grid);
+  // uploads the last clearance overlay, render thread only
+  void showClearance();
+
   boost::shared_ptr<message_filters::Subscriber<octomap_msgs::Octomap> > sub_;
 
+  // messages waiting for the worker pool
+  boost::mutex pending_mutex_;
+  std::deque<octomap_msgs::OctomapConstPtr> pending_messages_;
+  WorkerPool::Queue work_queue_;
+
+  // the last decoded map and its header, only accessed by pool tasks
+  ArenaOcTree octree_;
+  std_msgs::Header map_header_;
+  AllocationCounter::Counts decode_allocations_;
+
   unsigned int octree_depth_;
   rviz::IntProperty* tree_depth_property_;
+  rviz::IntProperty* memory_limit_property_;
+  rviz::IntProperty* worker_threads_property_;
+  rviz::EnumProperty* projection_property_;
+  rviz::StringProperty* z_bands_property_;
+  std::vector<rviz::BoolProperty*> band_properties_;
+  rviz::BoolProperty* window_property_;
+  rviz::TfFrameProperty* window_frame_property_;
+  rviz::FloatProperty* window_size_property_;
+  rviz::BoolProperty* clearance_property_;
+  rviz::FloatProperty* max_distance_property_;
+
+  // bands parsed from z_bands_property_ and their visibility, guarded by
+  // band_mutex_
+  boost::mutex band_mutex_;
+  std::vector<MapProjector::ZBand> z_bands_;
+  std::vector<bool> shown_bands_;
+
+  // one grid per band of the last map, only accessed by pool tasks
+  std::vector<nav_msgs::OccupancyGrid> band_grids_;
+  // the rolling window of the last map if there are no bands, only
+  // accessed by pool tasks
+  std::vector<nav_msgs::OccupancyGrid> window_grids_;
+
+  // frame of the last map, the window center in it and the cell size of
+  // the last window, guarded by window_mutex_
+  boost::mutex window_mutex_;
+  std::string map_frame_;
+  bool window_center_valid_;
+  double window_center_[2];
+  double window_cell_size_;
+
+  // render thread only
+  bool window_transform_ok_;
+
+  // distances of the last shown grid, only accessed by pool tasks
+  DistanceTransform distance_transform_;
+
+  // shaded cells of the last shown grid for the render thread, guarded by
+  // clearance_mutex_
+  boost::mutex clearance_mutex_;
+  std::vector<rviz::PointCloud::Point> clearance_points_;
+  float clearance_cell_size_;
+  bool clearance_received_;
+
+  // drawn above the map, render thread only
+  Ogre::SceneNode* clearance_node_;
+  rviz::PointCloud* clearance_cloud_;
+
+  MemoryAccounting memory_;
 
 };
 
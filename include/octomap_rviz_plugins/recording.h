@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef RVIZ_OCTOMAP_RECORDING_H
+#define RVIZ_OCTOMAP_RECORDING_H
+
+#include <octomap_msgs/Octomap.h>
+
+#include <fstream>
+#include <string>
+
+namespace octomap_rviz_plugin
+{
+
+// One received octomap message together with the view it was displayed in.
+// Poses are given in the rviz fixed frame, orientations as w, x, y, z.
+struct RecordedFrame
+{
+  // wall clock seconds since the recording was started
+  double receive_time;
+  float map_position[3];
+  float map_orientation[4];
+  float camera_position[3];
+  float camera_orientation[4];
+  octomap_msgs::Octomap message;
+};
+
+// Appends frames to a recording file. The file is a small header followed by
+// the raw frames in native byte order; the octomap payload is stored as it was
+// received, so a recording is about as large as the messages themselves.
+class RecordingWriter
+{
+public:
+  bool open(const std::string& path);
+  void close();
+  bool isOpen() const { return stream_.is_open(); }
+
+  bool write(const RecordedFrame& frame);
+
+private:
+  std::ofstream stream_;
+};
+
+// Reads the frames of a recording in the order they were written.
+class RecordingReader
+{
+public:
+  bool open(const std::string& path);
+  void close();
+
+  // returns false at the end of the file or if the data is broken
+  bool read(RecordedFrame& frame);
+
+private:
+  std::ifstream stream_;
+};
+
+} // namespace octomap_rviz_plugin
+
+#endif //RVIZ_OCTOMAP_RECORDING_H
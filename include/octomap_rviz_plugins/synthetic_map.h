@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef RVIZ_OCTOMAP_SYNTHETIC_MAP_H
+#define RVIZ_OCTOMAP_SYNTHETIC_MAP_H
+
+#include <octomap_msgs/Octomap.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace octomap_rviz_plugin
+{
+
+// Generates fixed binary octomap messages for the benchmark. The maps are a
+// pure function of scene and size, so their pipeline output can be compared
+// against golden checksums.
+class SyntheticMap
+{
+public:
+  enum Scene
+  {
+    // closed room with furniture boxes, large uniform free and occupied regions
+    ROOM,
+    // rolling height field, a thin occupied surface above unknown space
+    TERRAIN,
+    // hashed per-voxel occupancy, nothing can be pruned
+    NOISE,
+    NUM_SCENES
+  };
+
+  static const char* sceneName(Scene scene);
+
+  // fills msg with a map of size^3 leaf voxels (size a power of two <= 1024)
+  static void generate(Scene scene, unsigned int size, double resolution, octomap_msgs::Octomap& msg);
+
+private:
+  // -1 unknown, 0 free, 1 occupied
+  static int classify(Scene scene, unsigned int size, unsigned int x, unsigned int y, unsigned int z);
+
+  struct BuildNode
+  {
+    // -1 unknown, 0 free, 1 occupied, 2 inner node
+    int8_t value;
+    uint32_t children[8];
+  };
+
+  // returns the index of the generated node in nodes, 0 if it is unknown
+  static uint32_t build(Scene scene, unsigned int size, unsigned int depth, unsigned int x, unsigned int y,
+                        unsigned int z, std::vector<BuildNode>& nodes);
+
+  static void encode(const std::vector<BuildNode>& nodes, uint32_t index, std::vector<int8_t>& data);
+};
+
+} // namespace octomap_rviz_plugin
+
+#endif //RVIZ_OCTOMAP_SYNTHETIC_MAP_H
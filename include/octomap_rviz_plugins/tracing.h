@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef RVIZ_OCTOMAP_TRACING_H
+#define RVIZ_OCTOMAP_TRACING_H
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <stdint.h>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace octomap_rviz_plugin
+{
+
+// Process wide recorder of scoped events in the Chrome trace event format,
+// which can be loaded into chrome://tracing or Perfetto. Tracing is off
+// unless the OCTOMAP_RVIZ_TRACE environment variable names an output file
+// or start() is called; a disabled TraceScope costs a single branch.
+class Tracer
+{
+public:
+  static Tracer& instance();
+
+  // starts writing events to path, returns false if it cannot be opened
+  bool start(const std::string& path);
+  // writes pending events and closes the trace file
+  void stop();
+
+  bool isEnabled() const { return enabled_; }
+
+  // records a complete event of the calling thread, times in microseconds
+  void addEvent(const char* name, uint64_t begin, uint64_t end);
+
+  // monotonic time in microseconds
+  static uint64_t now();
+
+private:
+  Tracer();
+  ~Tracer();
+
+  struct Event
+  {
+    const char* name;
+    uint64_t begin;
+    uint64_t duration;
+    unsigned int thread;
+  };
+
+  // writes buffered events, the caller has to hold mutex_
+  void flush();
+
+  volatile bool enabled_;
+
+  boost::mutex mutex_;
+  std::ofstream file_;
+  std::vector<Event> events_;
+  // small sequential ids are easier to read in the viewer than native ones
+  std::map<boost::thread::id, unsigned int> thread_ids_;
+};
+
+// records the lifetime of the scope as one event named name, which has to
+// be a string literal
+class TraceScope
+{
+public:
+  explicit TraceScope(const char* name) :
+      name_(name),
+      begin_(Tracer::instance().isEnabled() ? Tracer::now() : 0)
+  {
+  }
+
+  ~TraceScope()
+  {
+    if (begin_)
+      Tracer::instance().addEvent(name_, begin_, Tracer::now());
+  }
+
+private:
+  const char* name_;
+  uint64_t begin_;
+};
+
+} // namespace octomap_rviz_plugin
+
+#endif //RVIZ_OCTOMAP_TRACING_H
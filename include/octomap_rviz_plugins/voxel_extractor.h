@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Author: Julius Kammerl (jkammerl@willowgarage.com)
+ *
+ */
+
+#ifndef RVIZ_OCTOMAP_VOXEL_EXTRACTOR_H
+#define RVIZ_OCTOMAP_VOXEL_EXTRACTOR_H
+
+#include "rviz/ogre_helpers/point_cloud.h"
+
+#include "octomap_rviz_plugins/arena_octree.h"
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+namespace octomap_rviz_plugin
+{
+
+// Turns an ArenaOcTree into colored boxes for rviz::PointCloud, one bucket
+// per octree depth. Voxels which have neighbors of the same set on all 26
+// sides are culled. The extractor does not depend on any display state, so
+// the replay benchmark runs exactly the code used for rendering.
+class VoxelExtractor
+{
+public:
+  // occupied and free voxels are extracted and culled independently
+  enum VoxelSet
+  {
+    OCCUPIED_SET,
+    FREE_SET,
+    NUM_VOXEL_SETS
+  };
+
+  enum ColorMode
+  {
+    Z_AXIS_COLOR,
+    PROBABILITY_COLOR
+  };
+
+  typedef std::vector<rviz::PointCloud::Point> VPoint;
+  typedef std::vector<VPoint> VVPoint;
+
+  VoxelExtractor();
+
+  void setColorMode(ColorMode mode) { color_mode_ = mode; }
+  void setColorFactor(double factor) { color_factor_ = factor; }
+
+  // shows a uniform subtree as one voxel if the colors of its voxels differ
+  // by at most tolerance (0..1), 0 keeps all voxels
+  void setMergeTolerance(double tolerance) { merge_tolerance_ = tolerance; }
+
+  // fills points (indexed by depth - 1) with the visible voxels of a set up to
+  // tree_depth, returns false if more than max_points voxels would have been
+  // extracted
+  bool extract(const ArenaOcTree& octree, VoxelSet set, unsigned int tree_depth, std::size_t max_points,
+               VVPoint& points, std::size_t& point_count);
+
+  // like extract, but only for the subtree below the current node of region.
+  // Neighbors outside of the region still hide voxels, and regions visited in
+  // iterator order yield the voxels of extract in the same order.
+  bool extractRegion(const ArenaOcTree& octree, VoxelSet set, const ArenaOcTree::iterator& region,
+                     unsigned int tree_depth, std::size_t max_points, VVPoint& points, std::size_t& point_count);
+
+  // like extract, but visits subtrees in order of their distance to focus
+  // (in the map frame) and stops after the max_points nearest visible voxels,
+  // so the cost is bounded by the budget rather than the map size. Returns
+  // false if the budget cut off part of the map.
+  bool extractNearest(const ArenaOcTree& octree, VoxelSet set, unsigned int tree_depth, const double focus[3],
+                      std::size_t max_points, VVPoint& points, std::size_t& point_count);
+
+  // bytes held by the scratch buffers
+  std::size_t memoryUsage() const;
+
+  // size of the scratch data kept per extracted voxel
+  static std::size_t bytesPerVoxel();
+
+  // method taken from octomap_server package
+  static void setColor(double z_pos, double min_z, double max_z, double color_factor,
+                       rviz::PointCloud::Point& point);
+
+protected:
+  // resets the scratch buffers for an extraction of octree
+  void begin(const ArenaOcTree& octree);
+
+  // collects the candidates of the leafs returned by it, which has to stop at
+  // nodes with solid_flags
+  void collectCandidates(ArenaOcTree::iterator it, unsigned int tree_depth, uint8_t solid_flags, int set_mask);
+
+  // culls the candidates and colors the visible voxels
+  bool finish(int set_mask, std::size_t max_points, VVPoint& points, std::size_t& point_count);
+
+  // collects the surface candidates of a subtree whose extent is entirely
+  // covered by voxels counting as neighbors, skipping interior parts in bulk
+  void collectSolidSubtree(const ArenaOcTree::Node* node, const octomap::OcTreeKey& key, unsigned int depth,
+                           unsigned int tree_depth, uint8_t solid_flags,
+                           const octomap::OcTreeKey& solid_min_key, unsigned int solid_level, int set_mask);
+
+  // true if all 26 neighbors of the node at key/depth have solid_flags set
+  bool isShellSolid(const octomap::OcTreeKey& key, unsigned int depth, uint8_t solid_flags);
+
+  // true if the solid node at depth can be shown as a single voxel within
+  // the merge tolerance
+  bool isMergeable(const ArenaOcTree::Node* node, unsigned int depth, unsigned int tree_depth) const;
+
+  // widens the log-odds range by the leafs below node, returns false as soon
+  // as their probabilities differ by more than the merge tolerance
+  bool isWithinTolerance(const ArenaOcTree::Node* node, unsigned int depth, unsigned int tree_depth,
+                         float& min_log_odds, float& max_log_odds) const;
+
+  // queues a leaf of the set for the neighbor test, merged nodes are known
+  // to be visible already
+  void addCandidate(const ArenaOcTree::Node& voxel, const octomap::OcTreeKey& key, unsigned int depth,
+                    int set_mask, bool merged = false);
+
+  // keeps the candidates from index first on with at least one missing
+  // neighbor, returns false once more than max_points would be visible
+  bool cullCandidates(int set_mask, std::size_t first, std::size_t max_points, std::size_t& point_count);
+
+  // queues a node for best-first traversal by its distance to focus
+  void pushFrontier(const ArenaOcTree::Node* node, const octomap::OcTreeKey& key, unsigned int depth,
+                    const double focus[3]);
+
+  // sorts the visible voxels and converts them into colored points
+  void colorVoxels(VVPoint& points);
+
+  // leaf of the extracted set found during traversal
+  struct Candidate
+  {
+    const ArenaOcTree::Node* node;
+    octomap::OcTreeKey key;
+    unsigned int depth;
+    bool merged;
+  };
+
+  // visible voxel tagged with the Morton code of its octree key
+  struct Voxel
+  {
+    uint64_t code;
+    float position[3];
+    float log_odds;
+  };
+  typedef std::vector<Voxel> VVoxel;
+
+  // node waiting for best-first traversal, ordered so that the heap top is
+  // the node nearest to the focus
+  struct FrontierNode
+  {
+    double distance_squared;
+    const ArenaOcTree::Node* node;
+    octomap::OcTreeKey key;
+    unsigned int depth;
+
+    bool operator<(const FrontierNode& other) const { return distance_squared > other.distance_squared; }
+  };
+  typedef std::vector<VVoxel> VVVoxel;
+
+  // tree of the running extraction
+  const ArenaOcTree* octree_;
+  double min_z_;
+  double max_z_;
+
+  // candidates and visible voxels of the current extraction per depth and
+  // radix sort scratch space
+  std::vector<Candidate> candidates_;
+  std::vector<FrontierNode> frontier_;
+  VVVoxel voxel_buf_;
+  VVoxel sort_buf_;
+
+  ColorMode color_mode_;
+  double color_factor_;
+  double merge_tolerance_;
+};
+
+} // namespace octomap_rviz_plugin
+
+#endif //RVIZ_OCTOMAP_VOXEL_EXTRACTOR_H
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef RVIZ_OCTOMAP_WORKER_POOL_H
+#define RVIZ_OCTOMAP_WORKER_POOL_H
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+namespace octomap_rviz_plugin
+{
+
+// Process wide pool of worker threads shared by all octomap displays, so
+// that several displays do not oversubscribe the CPU and starve the render
+// thread. Work is submitted through queues, usually one per display. Each
+// worker keeps a deque of ready queues and steals from the others when its
+// own runs empty; queues of high priority are always served first.
+class WorkerPool
+{
+public:
+  typedef boost::function<void ()> Task;
+
+  enum Priority
+  {
+    HIGH_PRIORITY,
+    LOW_PRIORITY,
+    NUM_PRIORITIES
+  };
+
+  // Tasks of one queue run one after another in submission order, tasks of
+  // different queues run in parallel.
+  class Queue : boost::noncopyable
+  {
+  public:
+    Queue();
+    // cancels pending tasks and waits for the running one
+    ~Queue();
+
+    void submit(const Task& task);
+    void setPriority(Priority priority);
+
+    // drops pending tasks and waits for the running one, must not be called
+    // from a task of this queue
+    void cancel();
+
+    // number of pending and running tasks
+    std::size_t depth() const;
+
+  private:
+    friend class WorkerPool;
+
+    std::deque<Task> tasks_;
+    Priority priority_;
+    bool scheduled_;
+    bool running_;
+    boost::condition_variable idle_;
+  };
+
+  static WorkerPool& instance();
+
+  // 0 uses one thread less than the number of cores, leaving one for the
+  // render thread. Does not wait for running tasks, surplus workers exit
+  // once their task is done.
+  void setThreadCount(unsigned int threads);
+  unsigned int threadCount() const;
+
+private:
+  WorkerPool();
+  ~WorkerPool();
+
+  // the caller has to hold mutex_
+  void schedule(Queue* queue);
+  void unschedule(Queue* queue);
+  Queue* take(std::size_t worker);
+  std::size_t currentWorker() const;
+
+  // the caller has to hold mutex_
+  void start(std::size_t threads);
+  void stop(boost::mutex::scoped_lock& lock);
+  // joins retired workers which already exited, the caller has to hold
+  // mutex_
+  void reapRetired();
+  // true if worker was removed by setThreadCount(), the caller has to hold
+  // mutex_ and run on the worker's thread
+  bool isRetired(std::size_t worker) const;
+  void run(std::size_t worker);
+
+  mutable boost::mutex mutex_;
+  boost::condition_variable work_;
+
+  // ready queues per priority and worker
+  std::vector<std::deque<Queue*> > ready_[NUM_PRIORITIES];
+  std::vector<boost::thread*> threads_;
+  // removed workers until they are joined, and the ones which exited
+  std::vector<boost::thread*> retired_threads_;
+  std::vector<boost::thread::id> exited_threads_;
+  std::size_t next_worker_;
+  bool stopping_;
+};
+
+} // namespace octomap_rviz_plugin
+
+#endif //RVIZ_OCTOMAP_WORKER_POOL_H
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef RVIZ_OCTOMAP_Z_LAYER_INDEX_H
+#define RVIZ_OCTOMAP_Z_LAYER_INDEX_H
+
+#include "rviz/ogre_helpers/point_cloud.h"
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+namespace octomap_rviz_plugin
+{
+
+// Buckets equally sized voxels by their Z layer, so that all voxels within a
+// height range can be gathered without looking at the others. Building the
+// index is a counting sort and linear in the number of voxels.
+class ZLayerIndex
+{
+public:
+  ZLayerIndex();
+
+  // indexes points whose centers lie on a grid of spacing layer_height
+  void build(const std::vector<rviz::PointCloud::Point>& points, double layer_height);
+  void clear();
+
+  // appends all points of the indexed vector whose center lies in
+  // [min_z, max_z] to out
+  void select(const std::vector<rviz::PointCloud::Point>& points, double min_z, double max_z,
+              std::vector<rviz::PointCloud::Point>& out) const;
+
+  std::size_t memoryUsage() const;
+
+  void swap(ZLayerIndex& other);
+
+private:
+  int layerOf(double z) const;
+
+  double min_z_;
+  double layer_height_;
+  // point indices ordered by layer, layer_start_[l] is the first entry of
+  // layer l and layer_start_.back() the number of points
+  std::vector<uint32_t> order_;
+  std::vector<uint32_t> layer_start_;
+};
+
+} // namespace octomap_rviz_plugin
+
+#endif //RVIZ_OCTOMAP_Z_LAYER_INDEX_H
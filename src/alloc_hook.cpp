@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Replacement of the global operator new/delete which counts allocations per
+// thread. Build as a shared library and load it with
+//   LD_PRELOAD=liboctomap_rviz_alloc_hook.so rviz
+// to get allocation statistics from the octomap displays and the benchmark.
+
+#include <stdint.h>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+__thread uint64_t allocations_ = 0;
+__thread uint64_t allocated_bytes_ = 0;
+
+void* countedAlloc(std::size_t size)
+{
+  ++allocations_;
+  allocated_bytes_ += size;
+  return std::malloc(size ? size : 1);
+}
+
+} // namespace
+
+// dynamic exception specifications were removed in C++17
+#if __cplusplus >= 201103L
+#define ALLOC_HOOK_THROW_BAD_ALLOC
+#define ALLOC_HOOK_NOTHROW noexcept
+#else
+#define ALLOC_HOOK_THROW_BAD_ALLOC throw(std::bad_alloc)
+#define ALLOC_HOOK_NOTHROW throw()
+#endif
+
+extern "C" void octomap_rviz_alloc_counters(uint64_t* allocations, uint64_t* bytes)
+{
+  *allocations = allocations_;
+  *bytes = allocated_bytes_;
+}
+
+void* operator new(std::size_t size) ALLOC_HOOK_THROW_BAD_ALLOC
+{
+  void* p = countedAlloc(size);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](std::size_t size) ALLOC_HOOK_THROW_BAD_ALLOC
+{
+  void* p = countedAlloc(size);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) ALLOC_HOOK_NOTHROW
+{
+  return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) ALLOC_HOOK_NOTHROW
+{
+  return countedAlloc(size);
+}
+
+void operator delete(void* p) ALLOC_HOOK_NOTHROW
+{
+  std::free(p);
+}
+
+void operator delete[](void* p) ALLOC_HOOK_NOTHROW
+{
+  std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) ALLOC_HOOK_NOTHROW
+{
+  std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) ALLOC_HOOK_NOTHROW
+{
+  std::free(p);
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "octomap_rviz_plugins/allocation_counter.h"
+#include "octomap_rviz_plugins/memory_accounting.h"
+
+#include <dlfcn.h>
+
+#include <sstream>
+
+namespace octomap_rviz_plugin
+{
+
+// exported by liboctomap_rviz_alloc_hook
+typedef void (*AllocationCountersFunc)(uint64_t* allocations, uint64_t* bytes);
+
+static AllocationCountersFunc lookupCounters()
+{
+  // the hook is only present if it was preloaded, so it is looked up at
+  // runtime instead of being linked
+  static AllocationCountersFunc func =
+      reinterpret_cast<AllocationCountersFunc>(dlsym(RTLD_DEFAULT, "octomap_rviz_alloc_counters"));
+  return func;
+}
+
+bool AllocationCounter::available()
+{
+  return lookupCounters() != NULL;
+}
+
+AllocationCounter::Counts AllocationCounter::current()
+{
+  Counts counts;
+
+  AllocationCountersFunc func = lookupCounters();
+  if (func)
+    func(&counts.allocations, &counts.bytes);
+
+  return counts;
+}
+
+std::string AllocationCounter::format(const Counts& counts)
+{
+  std::stringstream ss;
+  ss << counts.allocations << " allocations (" << MemoryAccounting::formatBytes(counts.bytes) << ")";
+  return ss.str();
+}
+
+} // namespace octomap_rviz_plugin
@@ -0,0 +1,504 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "octomap_rviz_plugins/arena_octree.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace octomap_rviz_plugin
+{
+
+// default thresholds of octomap::OcTree, in log odds
+static const float occupancy_thres_log = 0.0f;      // p = 0.5
+static const float clamping_thres_min_log = -2.0f;  // p = 0.1192
+static const float clamping_thres_max_log = 3.5f;   // p = 0.971
+
+static unsigned int countBits(uint8_t v)
+{
+  unsigned int count = 0;
+  for (; v; v &= v - 1)
+    ++count;
+  return count;
+}
+
+ArenaOcTree::iterator::iterator() :
+    tree_(NULL),
+    max_depth_(0),
+    stop_flags_(0)
+{
+}
+
+ArenaOcTree::iterator::iterator(const ArenaOcTree* tree, unsigned int max_depth, uint8_t stop_flags) :
+    tree_(tree),
+    max_depth_((max_depth == 0 || max_depth > tree->getTreeDepth()) ? tree->getTreeDepth() : max_depth),
+    stop_flags_(stop_flags)
+{
+  if (tree_->getRoot())
+  {
+    stack_.reserve(8 * tree_->getTreeDepth());
+
+    StackEntry root;
+    root.node = tree_->getRoot();
+    root.key[0] = root.key[1] = root.key[2] = tree_->tree_max_val_;
+    root.depth = 0;
+    stack_.push_back(root);
+
+    descend();
+  }
+}
+
+ArenaOcTree::iterator::iterator(const iterator& parent, unsigned int max_depth, uint8_t stop_flags) :
+    tree_(parent.tree_),
+    max_depth_((max_depth == 0 || max_depth > tree_->getTreeDepth()) ? tree_->getTreeDepth() : max_depth),
+    stop_flags_(stop_flags)
+{
+  if (!parent.stack_.empty())
+  {
+    stack_.reserve(8 * tree_->getTreeDepth());
+    stack_.push_back(parent.current());
+
+    descend();
+  }
+}
+
+bool ArenaOcTree::iterator::operator==(const iterator& other) const
+{
+  if (stack_.empty() || other.stack_.empty())
+    return stack_.empty() && other.stack_.empty();
+
+  return tree_ == other.tree_ && stack_.size() == other.stack_.size() && current().node == other.current().node;
+}
+
+ArenaOcTree::iterator& ArenaOcTree::iterator::operator++()
+{
+  if (!stack_.empty())
+  {
+    stack_.pop_back();
+    descend();
+  }
+  return *this;
+}
+
+void ArenaOcTree::iterator::descend()
+{
+  while (!stack_.empty())
+  {
+    StackEntry top = stack_.back();
+    if (top.depth >= max_depth_ || !top.node->hasChildren() || (stop_flags_ && top.node->hasFlags(stop_flags_)))
+      return;
+
+    stack_.pop_back();
+
+    // push in reverse order so that child 0 is visited first
+    key_type center_offset_key = tree_->getCenterOffsetKey(top.depth);
+    for (int i = 7; i >= 0; --i)
+    {
+      if (top.node->childExists(i))
+      {
+        StackEntry child;
+        child.node = tree_->getNodeChild(top.node, i);
+        computeChildKey(i, center_offset_key, top.key, child.key);
+        child.depth = top.depth + 1;
+        stack_.push_back(child);
+      }
+    }
+  }
+}
+
+ArenaOcTree::ArenaOcTree() :
+    read_pos_(NULL),
+    read_end_(NULL),
+    tree_depth_(16),
+    tree_max_val_(32768),
+    resolution_(0.0),
+    occupancy_thres_log_(occupancy_thres_log),
+    clamping_thres_min_(clamping_thres_min_log),
+    clamping_thres_max_(clamping_thres_max_log),
+    num_leafs_(0)
+{
+  std::fill(metric_min_, metric_min_ + 3, 0.0);
+  std::fill(metric_max_, metric_max_ + 3, 0.0);
+}
+
+bool ArenaOcTree::readMessage(const octomap_msgs::Octomap& msg)
+{
+  clear();
+
+  if (msg.id != "OcTree" || msg.data.empty() || msg.resolution <= 0.0)
+    return false;
+
+  const char* data = reinterpret_cast<const char*>(&msg.data[0]);
+  if (msg.binary)
+    return readBinaryData(data, msg.data.size(), msg.resolution);
+  else
+    return readFullData(data, msg.data.size(), msg.resolution);
+}
+
+bool ArenaOcTree::readBinaryData(const char* data, std::size_t size, double resolution)
+{
+  clear();
+  resolution_ = resolution;
+  read_pos_ = data;
+  read_end_ = data + size;
+
+  uint32_t root = allocateNodes(1);
+  nodes_[root].log_odds = clamping_thres_max_;
+
+  if (!readBinaryNode(root, 0))
+  {
+    clear();
+    return false;
+  }
+
+  if (!nodes_[root].hasChildren())
+    ++num_leafs_;
+
+  computeFlags(root);
+  computeMetricBounds();
+  return true;
+}
+
+bool ArenaOcTree::readFullData(const char* data, std::size_t size, double resolution)
+{
+  clear();
+  resolution_ = resolution;
+  read_pos_ = data;
+  read_end_ = data + size;
+
+  uint32_t root = allocateNodes(1);
+  if (!readFullNode(root, 0))
+  {
+    clear();
+    return false;
+  }
+
+  computeFlags(root);
+  computeMetricBounds();
+  return true;
+}
+
+void ArenaOcTree::clear()
+{
+  nodes_.clear();
+  num_leafs_ = 0;
+  read_pos_ = read_end_ = NULL;
+  std::fill(metric_min_, metric_min_ + 3, 0.0);
+  std::fill(metric_max_, metric_max_ + 3, 0.0);
+}
+
+void ArenaOcTree::release()
+{
+  clear();
+  std::vector<Node>().swap(nodes_);
+}
+
+uint32_t ArenaOcTree::allocateNodes(unsigned int count)
+{
+  uint32_t first = static_cast<uint32_t>(nodes_.size());
+
+  Node empty_node;
+  empty_node.log_odds = 0.0f;
+  empty_node.first_child = 0;
+  empty_node.child_mask = 0;
+  empty_node.flags = 0;
+  nodes_.resize(nodes_.size() + count, empty_node);
+
+  return first;
+}
+
+// same encoding as octomap::OcTree::writeBinaryNode: child i is described by
+// bits 2i and 2i+1 of the two header bytes, 1 = free leaf, 2 = occupied leaf,
+// 3 = inner node and 0 = unknown
+bool ArenaOcTree::readBinaryNode(uint32_t index, unsigned int depth)
+{
+  if (depth >= tree_depth_ || read_end_ - read_pos_ < 2)
+    return false;
+
+  uint8_t child_bits[2];
+  child_bits[0] = static_cast<uint8_t>(read_pos_[0]);
+  child_bits[1] = static_cast<uint8_t>(read_pos_[1]);
+  read_pos_ += 2;
+
+  uint8_t child_mask = 0;
+  uint8_t inner_mask = 0;
+  float values[8];
+  for (unsigned int i = 0; i < 8; ++i)
+  {
+    unsigned int bits = (child_bits[i / 4] >> ((i % 4) * 2)) & 3;
+    switch (bits)
+    {
+      case 1: // free leaf
+        values[i] = clamping_thres_min_;
+        break;
+      case 2: // occupied leaf
+        values[i] = clamping_thres_max_;
+        break;
+      case 3: // inner node, value is set from its children
+        values[i] = clamping_thres_max_;
+        inner_mask |= 1 << i;
+        break;
+      default: // unknown
+        continue;
+    }
+    child_mask |= 1 << i;
+  }
+
+  uint32_t child = allocateNodes(countBits(child_mask));
+  nodes_[index].first_child = child;
+  nodes_[index].child_mask = child_mask;
+
+  float max_log_odds = -std::numeric_limits<float>::max();
+  for (unsigned int i = 0; i < 8; ++i)
+  {
+    if (!(child_mask & (1 << i)))
+      continue;
+
+    nodes_[child].log_odds = values[i];
+
+    if (inner_mask & (1 << i))
+    {
+      if (!readBinaryNode(child, depth + 1))
+        return false;
+    }
+
+    if (!nodes_[child].hasChildren())
+      ++num_leafs_;
+
+    max_log_odds = std::max(max_log_odds, nodes_[child].log_odds);
+    ++child;
+  }
+
+  // inner nodes carry the maximum occupancy of their children
+  if (child_mask)
+    nodes_[index].log_odds = max_log_odds;
+
+  return true;
+}
+
+// same encoding as octomap::OcTree::writeData: the float log odds value of
+// every node followed by a child bit mask, children recursively in order
+bool ArenaOcTree::readFullNode(uint32_t index, unsigned int depth)
+{
+  if (read_end_ - read_pos_ < (std::ptrdiff_t)(sizeof(float) + 1))
+    return false;
+
+  float value;
+  std::memcpy(&value, read_pos_, sizeof(float));
+  uint8_t child_mask = static_cast<uint8_t>(read_pos_[sizeof(float)]);
+  read_pos_ += sizeof(float) + 1;
+
+  if (child_mask && depth >= tree_depth_)
+    return false;
+
+  nodes_[index].log_odds = value;
+
+  if (!child_mask)
+  {
+    ++num_leafs_;
+    return true;
+  }
+
+  uint32_t child = allocateNodes(countBits(child_mask));
+  nodes_[index].first_child = child;
+  nodes_[index].child_mask = child_mask;
+
+  for (uint32_t end = child + countBits(child_mask); child < end; ++child)
+  {
+    if (!readFullNode(child, depth + 1))
+      return false;
+  }
+
+  return true;
+}
+
+uint8_t ArenaOcTree::computeFlags(uint32_t index)
+{
+  Node& node = nodes_[index];
+  if (!node.hasChildren())
+  {
+    node.flags = FLAG_COMPLETE | (isNodeOccupied(node) ? FLAG_UNIFORM_OCCUPIED : FLAG_UNIFORM_FREE);
+    return node.flags;
+  }
+
+  // children are stored in consecutive arena slots
+  uint8_t flags = (node.child_mask == 0xff) ? (FLAG_COMPLETE | FLAG_UNIFORM_FREE | FLAG_UNIFORM_OCCUPIED) : 0;
+  uint32_t child = node.first_child;
+  for (uint32_t end = child + countBits(node.child_mask); child < end; ++child)
+    flags &= computeFlags(child);
+
+  node.flags = flags;
+  return flags;
+}
+
+octomap::OcTreeKey ArenaOcTree::getRootKey() const
+{
+  octomap::OcTreeKey key;
+  key[0] = key[1] = key[2] = tree_max_val_;
+  return key;
+}
+
+const ArenaOcTree::Node* ArenaOcTree::getNodeChild(const Node* node, unsigned int i) const
+{
+  if (!node->childExists(i))
+    return NULL;
+
+  uint8_t preceding = node->child_mask & ((1 << i) - 1);
+  return &nodes_[node->first_child + countBits(preceding)];
+}
+
+const ArenaOcTree::Node* ArenaOcTree::search(const octomap::OcTreeKey& key, unsigned int depth) const
+{
+  const Node* node = getRoot();
+  if (!node)
+    return NULL;
+
+  if (depth == 0 || depth > tree_depth_)
+    depth = tree_depth_;
+
+  for (int i = tree_depth_ - 1; i >= (int)(tree_depth_ - depth); --i)
+  {
+    unsigned int pos = computeChildIdx(key, i);
+    if (node->childExists(pos))
+      node = getNodeChild(node, pos);
+    else
+      return node->hasChildren() ? NULL : node;
+  }
+
+  return node;
+}
+
+double ArenaOcTree::keyToCoord(key_type key, unsigned int depth) const
+{
+  if (depth == 0)
+    return 0.0;
+  if (depth == tree_depth_)
+    return (double(key) - double(tree_max_val_) + 0.5) * resolution_;
+
+  return (std::floor((double(key) - double(tree_max_val_)) / double(1 << (tree_depth_ - depth))) + 0.5)
+      * getNodeSize(depth);
+}
+
+octomap::OcTreeKey ArenaOcTree::getIndexKey(const octomap::OcTreeKey& key, unsigned int depth) const
+{
+  unsigned int level = tree_depth_ - depth;
+  if (level == 0)
+    return key;
+
+  key_type mask = static_cast<key_type>(0xffff << level);
+  octomap::OcTreeKey index_key;
+  index_key[0] = key[0] & mask;
+  index_key[1] = key[1] & mask;
+  index_key[2] = key[2] & mask;
+  return index_key;
+}
+
+bool ArenaOcTree::coordToKeyChecked(double coordinate, key_type& key) const
+{
+  int scaled = (int)std::floor(coordinate / resolution_) + tree_max_val_;
+  if (scaled < 0 || scaled >= 2 * tree_max_val_)
+    return false;
+
+  key = static_cast<key_type>(scaled);
+  return true;
+}
+
+octomap::OcTreeKey ArenaOcTree::coordToKey(double x, double y, double z) const
+{
+  octomap::OcTreeKey key;
+  double coord[3] = { x, y, z };
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    int scaled = (int)std::floor(coord[i] / resolution_) + tree_max_val_;
+    key[i] = static_cast<key_type>(std::min(std::max(scaled, 0), 2 * tree_max_val_ - 1));
+  }
+  return key;
+}
+
+void ArenaOcTree::getMetricMin(double& x, double& y, double& z) const
+{
+  x = metric_min_[0];
+  y = metric_min_[1];
+  z = metric_min_[2];
+}
+
+void ArenaOcTree::getMetricMax(double& x, double& y, double& z) const
+{
+  x = metric_max_[0];
+  y = metric_max_[1];
+  z = metric_max_[2];
+}
+
+void ArenaOcTree::computeMetricBounds()
+{
+  if (empty())
+    return;
+
+  std::fill(metric_min_, metric_min_ + 3, std::numeric_limits<double>::max());
+  std::fill(metric_max_, metric_max_ + 3, -std::numeric_limits<double>::max());
+
+  for (iterator it = begin(), end = this->end(); it != end; ++it)
+  {
+    double half_size = it.getSize() / 2.0;
+    double center[3] = { it.getX(), it.getY(), it.getZ() };
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      metric_min_[i] = std::min(metric_min_[i], center[i] - half_size);
+      metric_max_[i] = std::max(metric_max_[i], center[i] + half_size);
+    }
+  }
+}
+
+unsigned int ArenaOcTree::computeChildIdx(const octomap::OcTreeKey& key, int depth)
+{
+  unsigned int pos = 0;
+  if (key[0] & (1 << depth))
+    pos += 1;
+  if (key[1] & (1 << depth))
+    pos += 2;
+  if (key[2] & (1 << depth))
+    pos += 4;
+  return pos;
+}
+
+void ArenaOcTree::computeChildKey(unsigned int pos, key_type center_offset_key, const octomap::OcTreeKey& parent_key,
+                                  octomap::OcTreeKey& child_key)
+{
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    if (pos & (1 << i))
+      child_key[i] = parent_key[i] + center_offset_key;
+    else
+      child_key[i] = parent_key[i] - center_offset_key - (center_offset_key ? 0 : 1);
+  }
+}
+
+} // namespace octomap_rviz_plugin
@@ -0,0 +1,418 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "octomap_rviz_plugins/chunked_cloud.h"
+
+#include <OGRE/OgreSceneNode.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <sstream>
+
+namespace octomap_rviz_plugin
+{
+
+// chunk edge length in voxels, aligned with the octree grid so that a chunk
+// is one subtree and its voxels are contiguous in Morton order
+static const double chunk_voxels_ = ChunkedCloud::CHUNK_VOXELS;
+// batch edge length in chunks, batches are aligned subtrees as well
+static const double batch_chunks_ = 4.0;
+// clouds kept for reuse, the others are freed when their batch runs empty
+static const std::size_t max_free_clouds_ = 16;
+
+// clouds live on the render thread only
+static std::size_t last_generation_ = 0;
+
+static uint64_t gridKey(const rviz::PointCloud::Point& point, double cell_size)
+{
+  // 21 bits per axis, centered at the origin
+  uint64_t key = 0;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    int64_t coord = static_cast<int64_t>(std::floor(point.position[axis] / cell_size)) + (1 << 20);
+    key = (key << 21) | (static_cast<uint64_t>(coord) & 0x1fffff);
+  }
+  return key;
+}
+
+// FNV-1a over positions and colors
+static uint64_t hashPoints(const rviz::PointCloud::Point* points, std::size_t count)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(points);
+  for (std::size_t i = 0; i < count * sizeof(rviz::PointCloud::Point); ++i)
+  {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+ChunkedCloud::ChunkedCloud(Ogre::SceneNode* node, const std::string& name) :
+    node_(node),
+    name_(name),
+    next_cloud_id_(0),
+    render_mode_(rviz::PointCloud::RM_BOXES),
+    size_(0),
+    generation_(++last_generation_)
+{
+  dimensions_[0] = dimensions_[1] = dimensions_[2] = 1.0f;
+}
+
+ChunkedCloud::~ChunkedCloud()
+{
+  clear();
+
+  for (std::size_t i = 0; i < free_clouds_.size(); ++i)
+  {
+    node_->detachObject(free_clouds_[i]);
+    delete free_clouds_[i];
+  }
+}
+
+void ChunkedCloud::setRenderMode(rviz::PointCloud::RenderMode mode)
+{
+  if (mode == render_mode_)
+    return;
+
+  render_mode_ = mode;
+  for (std::size_t i = 0; i < batches_.size(); ++i)
+    batches_[i].cloud->setRenderMode(mode);
+  for (std::size_t i = 0; i < free_clouds_.size(); ++i)
+    free_clouds_[i]->setRenderMode(mode);
+}
+
+void ChunkedCloud::setDimensions(float width, float height, float depth)
+{
+  dimensions_[0] = width;
+  dimensions_[1] = height;
+  dimensions_[2] = depth;
+
+  for (std::size_t i = 0; i < batches_.size(); ++i)
+    batches_[i].cloud->setDimensions(width, height, depth);
+}
+
+std::size_t ChunkedCloud::update(VPoint& points, double voxel_size)
+{
+  // batches of the previous content by key, unkeyed ones cannot be matched
+  std::map<uint64_t, Batch> previous;
+  for (std::size_t i = 0; i < batches_.size(); ++i)
+  {
+    if (!batches_[i].keyed || !previous.insert(std::make_pair(batches_[i].key, batches_[i])).second)
+      releaseCloud(batches_[i].cloud);
+  }
+
+  double batch_size = voxel_size * chunk_voxels_ * batch_chunks_;
+  std::size_t uploaded = 0;
+  bool changed = previous.size() != batches_.size();
+
+  batch_buf_.clear();
+  chunk_buf_.clear();
+  for (std::size_t begin = 0, end = 0; begin < points.size(); begin = end)
+  {
+    Batch batch;
+    batch.key = gridKey(points[begin], batch_size);
+    batch.keyed = true;
+
+    for (end = begin + 1; end < points.size() && gridKey(points[end], batch_size) == batch.key; ++end)
+      ;
+
+    batch.points = end - begin;
+    batch.hash = hashPoints(&points[begin], batch.points);
+    batch.chunks = addChunks(&points[begin], batch.points, voxel_size);
+    batch.cloud = NULL;
+    batch.visible = true;
+
+    std::map<uint64_t, Batch>::iterator match = previous.find(batch.key);
+    if (match != previous.end())
+    {
+      batch.cloud = match->second.cloud;
+      batch.visible = match->second.visible;
+      bool unchanged = match->second.hash == batch.hash && match->second.points == batch.points;
+      previous.erase(match);
+
+      if (!unchanged)
+      {
+        // changed batches are shown until they are tested again
+        batch.cloud->clear();
+        batch.cloud->addPoints(&points[begin], batch.points);
+        uploaded += batch.points;
+        changed = true;
+        if (!batch.visible)
+        {
+          batch.visible = true;
+          batch.cloud->setVisible(true);
+        }
+      }
+    }
+
+    batch_buf_.push_back(batch);
+  }
+
+  // batches which ran empty give their clouds to the new ones
+  for (std::map<uint64_t, Batch>::iterator it = previous.begin(); it != previous.end(); ++it)
+  {
+    releaseCloud(it->second.cloud);
+    changed = true;
+  }
+
+  std::size_t begin = 0;
+  for (std::size_t i = 0; i < batch_buf_.size(); ++i)
+  {
+    Batch& batch = batch_buf_[i];
+    if (!batch.cloud)
+    {
+      batch.cloud = takeCloud();
+      batch.cloud->addPoints(&points[begin], batch.points);
+      uploaded += batch.points;
+      changed = true;
+    }
+    begin += batch.points;
+  }
+
+  batches_.swap(batch_buf_);
+  batch_buf_.clear();
+  chunks_.swap(chunk_buf_);
+  chunk_buf_.clear();
+  size_ = points.size();
+  if (changed)
+    generation_ = ++last_generation_;
+
+  return uploaded;
+}
+
+void ChunkedCloud::append(VPoint& points, double voxel_size)
+{
+  if (points.empty())
+    return;
+
+  Chunk chunk;
+  chunk.points = points.size();
+  computeBox(&points.front(), points.size(), voxel_size, chunk.box);
+  chunks_.push_back(chunk);
+
+  Batch batch;
+  batch.key = 0;
+  batch.keyed = false;
+  batch.hash = 0;
+  batch.points = points.size();
+  batch.chunks = 1;
+  batch.cloud = takeCloud();
+  batch.cloud->addPoints(&points.front(), points.size());
+  batch.visible = true;
+  batches_.push_back(batch);
+
+  size_ += points.size();
+  generation_ = ++last_generation_;
+}
+
+void ChunkedCloud::popFront(std::size_t count)
+{
+  while (count && !batches_.empty())
+  {
+    Batch& front = batches_.front();
+    std::size_t popped = std::min(count, front.points);
+
+    if (popped == front.points)
+    {
+      releaseCloud(front.cloud);
+      chunks_.erase(chunks_.begin(), chunks_.begin() + front.chunks);
+      batches_.pop_front();
+    }
+    else
+    {
+      front.cloud->popPoints(popped);
+      front.points -= popped;
+      // the content no longer matches the key
+      front.keyed = false;
+
+      // the box of a partially popped chunk still encloses its voxels
+      for (std::size_t left = popped; left;)
+      {
+        Chunk& chunk = chunks_.front();
+        if (chunk.points > left)
+        {
+          chunk.points -= left;
+          break;
+        }
+        left -= chunk.points;
+        chunks_.pop_front();
+        --front.chunks;
+      }
+    }
+
+    count -= popped;
+    size_ -= popped;
+    generation_ = ++last_generation_;
+  }
+}
+
+void ChunkedCloud::clear()
+{
+  for (std::size_t i = 0; i < batches_.size(); ++i)
+    releaseCloud(batches_[i].cloud);
+  batches_.clear();
+  chunks_.clear();
+  size_ = 0;
+  generation_ = ++last_generation_;
+}
+
+void ChunkedCloud::getChunkBoxes(std::vector<ChunkBox>& boxes) const
+{
+  boxes.resize(chunks_.size());
+  for (std::size_t i = 0; i < chunks_.size(); ++i)
+    boxes[i] = chunks_[i].box;
+}
+
+std::size_t ChunkedCloud::setChunkVisibility(std::size_t generation, const std::vector<uint8_t>& visible)
+{
+  std::size_t hidden = 0;
+  if (generation != generation_ || visible.size() != chunks_.size())
+  {
+    for (std::size_t i = 0; i < batches_.size(); ++i)
+      hidden += batches_[i].visible ? 0 : batches_[i].chunks;
+    return hidden;
+  }
+
+  std::size_t chunk = 0;
+  for (std::size_t i = 0; i < batches_.size(); ++i)
+  {
+    Batch& batch = batches_[i];
+    bool shown = false;
+    for (std::size_t end = chunk + batch.chunks; chunk < end; ++chunk)
+      shown = shown || visible[chunk];
+
+    if (batch.visible != shown)
+    {
+      batch.visible = shown;
+      batch.cloud->setVisible(shown);
+    }
+    hidden += batch.visible ? 0 : batch.chunks;
+  }
+  return hidden;
+}
+
+void ChunkedCloud::showAllChunks()
+{
+  for (std::size_t i = 0; i < batches_.size(); ++i)
+  {
+    if (!batches_[i].visible)
+    {
+      batches_[i].visible = true;
+      batches_[i].cloud->setVisible(true);
+    }
+  }
+}
+
+std::size_t ChunkedCloud::addChunks(const rviz::PointCloud::Point* points, std::size_t count, double voxel_size)
+{
+  double chunk_size = voxel_size * chunk_voxels_;
+  std::size_t chunks = 0;
+  for (std::size_t begin = 0, end = 0; begin < count; begin = end, ++chunks)
+  {
+    uint64_t key = gridKey(points[begin], chunk_size);
+    for (end = begin + 1; end < count && gridKey(points[end], chunk_size) == key; ++end)
+      ;
+
+    Chunk chunk;
+    chunk.points = end - begin;
+    computeBox(points + begin, chunk.points, voxel_size, chunk.box);
+    chunk_buf_.push_back(chunk);
+  }
+  return chunks;
+}
+
+void ChunkedCloud::computeBox(const rviz::PointCloud::Point* points, std::size_t count, double voxel_size,
+                              ChunkBox& box) const
+{
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    box.min[axis] = std::numeric_limits<float>::max();
+    box.max[axis] = -std::numeric_limits<float>::max();
+  }
+
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      box.min[axis] = std::min(box.min[axis], points[i].position[axis]);
+      box.max[axis] = std::max(box.max[axis], points[i].position[axis]);
+    }
+  }
+
+  // grow from the voxel centers to the voxel boxes, the dimensions are in
+  // pixels when the voxels are drawn as points
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    box.min[axis] -= 0.5 * voxel_size;
+    box.max[axis] += 0.5 * voxel_size;
+  }
+}
+
+rviz::PointCloud* ChunkedCloud::takeCloud()
+{
+  rviz::PointCloud* cloud;
+  if (!free_clouds_.empty())
+  {
+    cloud = free_clouds_.back();
+    free_clouds_.pop_back();
+  }
+  else
+  {
+    std::stringstream sname;
+    sname << name_ << " Chunk Nr." << next_cloud_id_++;
+    cloud = new rviz::PointCloud();
+    cloud->setName(sname.str());
+    cloud->setRenderMode(render_mode_);
+    node_->attachObject(cloud);
+  }
+
+  cloud->setDimensions(dimensions_[0], dimensions_[1], dimensions_[2]);
+  return cloud;
+}
+
+void ChunkedCloud::releaseCloud(rviz::PointCloud* cloud)
+{
+  if (free_clouds_.size() >= max_free_clouds_)
+  {
+    node_->detachObject(cloud);
+    delete cloud;
+    return;
+  }
+
+  // stays attached, an empty cloud renders nothing
+  cloud->clear();
+  cloud->setVisible(true);
+  free_clouds_.push_back(cloud);
+}
+
+} // namespace octomap_rviz_plugin
@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "octomap_rviz_plugins/distance_transform.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace octomap_rviz_plugin
+{
+
+// lines per range handed to a worker, smaller ranges are not worth a task
+static const int min_lines_per_chunk_ = 16;
+
+static const float no_obstacle_ = std::numeric_limits<float>::infinity();
+
+DistanceTransform::DistanceTransform()
+  : width_(0)
+  , height_(0)
+  , resolution_(0.0f)
+  , origin_x_(0.0)
+  , origin_y_(0.0)
+  , max_distance_(0.0)
+  , dirty_min_x_(0)
+  , dirty_max_x_(-1)
+  , window_min_x_(0)
+  , window_max_x_(-1)
+  , job_pass_(NULL)
+  , job_next_(0)
+  , job_end_(-1)
+  , job_chunk_(1)
+  , job_running_(0)
+{
+}
+
+std::size_t DistanceTransform::update(const nav_msgs::OccupancyGrid& grid, double max_distance)
+{
+  unsigned int width = grid.info.width;
+  unsigned int height = grid.info.height;
+  std::size_t cells = std::size_t(width) * height;
+  if (!cells || grid.data.size() < cells || grid.info.resolution <= 0.0f || max_distance <= 0.0)
+  {
+    clear();
+    return 0;
+  }
+
+  // a new geometry or limit invalidates all distances
+  bool full = width != width_ || height != height_ || grid.info.resolution != resolution_
+              || grid.info.origin.position.x != origin_x_ || grid.info.origin.position.y != origin_y_
+              || max_distance != max_distance_ || obstacles_.size() != cells;
+  if (full)
+  {
+    width_ = width;
+    height_ = height;
+    resolution_ = grid.info.resolution;
+    origin_x_ = grid.info.origin.position.x;
+    origin_y_ = grid.info.origin.position.y;
+    max_distance_ = max_distance;
+    obstacles_.assign(cells, 0);
+    column_distances_.resize(cells);
+    distances_.assign(cells, max_distance);
+  }
+
+  // bounding box of the changed obstacles
+  int min_x = full ? 0 : width, min_y = full ? 0 : height;
+  int max_x = full ? width - 1 : -1, max_y = full ? height - 1 : -1;
+  for (unsigned int y = 0; y < height; ++y)
+  {
+    const int8_t* row = &grid.data[y * width];
+    uint8_t* obstacles = &obstacles_[y * width];
+    for (unsigned int x = 0; x < width; ++x)
+    {
+      uint8_t obstacle = row[x] >= OCCUPIED_VALUE;
+      if (obstacle == obstacles[x])
+        continue;
+
+      obstacles[x] = obstacle;
+      min_x = std::min<int>(min_x, x);
+      min_y = std::min<int>(min_y, y);
+      max_x = std::max<int>(max_x, x);
+      max_y = std::max<int>(max_y, y);
+    }
+  }
+
+  if (max_x < min_x)
+    return 0;
+
+  // columns only depend on their own cells
+  runParallel(&DistanceTransform::transformColumns, min_x, max_x);
+
+  // only distances below the limit matter, so a change reaches no further
+  // than the limit and rows only need the columns up to twice the limit away
+  int radius = static_cast<int>(std::ceil(max_distance / resolution_));
+  dirty_min_x_ = std::max(0, min_x - radius);
+  dirty_max_x_ = std::min<int>(width - 1, max_x + radius);
+  window_min_x_ = std::max(0, min_x - 2 * radius);
+  window_max_x_ = std::min<int>(width - 1, max_x + 2 * radius);
+  int row_min = std::max(0, min_y - radius);
+  int row_max = std::min<int>(height - 1, max_y + radius);
+  runParallel(&DistanceTransform::transformRows, row_min, row_max);
+
+  return std::size_t(dirty_max_x_ - dirty_min_x_ + 1) * (row_max - row_min + 1);
+}
+
+void DistanceTransform::clear()
+{
+  width_ = 0;
+  height_ = 0;
+  obstacles_.clear();
+  column_distances_.clear();
+  distances_.clear();
+}
+
+std::size_t DistanceTransform::memoryUsage() const
+{
+  return obstacles_.capacity() * sizeof(uint8_t) + (column_distances_.capacity() + distances_.capacity())
+         * sizeof(float);
+}
+
+void DistanceTransform::transformColumns(int begin, int end)
+{
+  // distance to the nearest obstacle above, then below each cell. The rows
+  // are walked in memory order with the last obstacle kept per column.
+  std::vector<int> last(end - begin + 1, -1);
+  for (int y = 0; y < int(height_); ++y)
+  {
+    const uint8_t* obstacles = &obstacles_[std::size_t(y) * width_];
+    float* distances = &column_distances_[std::size_t(y) * width_];
+    for (int x = begin; x <= end; ++x)
+    {
+      int& l = last[x - begin];
+      if (obstacles[x])
+        l = y;
+      distances[x] = l < 0 ? no_obstacle_ : float(y - l) * float(y - l);
+    }
+  }
+
+  std::fill(last.begin(), last.end(), -1);
+  for (int y = int(height_) - 1; y >= 0; --y)
+  {
+    const uint8_t* obstacles = &obstacles_[std::size_t(y) * width_];
+    float* distances = &column_distances_[std::size_t(y) * width_];
+    for (int x = begin; x <= end; ++x)
+    {
+      int& l = last[x - begin];
+      if (obstacles[x])
+        l = y;
+      if (l >= 0)
+        distances[x] = std::min(distances[x], float(l - y) * float(l - y));
+    }
+  }
+}
+
+void DistanceTransform::transformRows(int begin, int end)
+{
+  // lower envelope of the parabolas rooted at the columns of the window,
+  // columns without obstacles contribute none
+  std::size_t window = window_max_x_ - window_min_x_ + 1;
+  std::vector<int> roots(window);
+  std::vector<double> bounds(window + 1);
+
+  for (int y = begin; y <= end; ++y)
+  {
+    const float* f = &column_distances_[std::size_t(y) * width_];
+    float* distances = &distances_[std::size_t(y) * width_];
+
+    int k = -1;
+    for (int q = window_min_x_; q <= window_max_x_; ++q)
+    {
+      if (f[q] == no_obstacle_)
+        continue;
+
+      if (k < 0)
+      {
+        k = 0;
+        roots[0] = q;
+        bounds[0] = -std::numeric_limits<double>::infinity();
+        bounds[1] = std::numeric_limits<double>::infinity();
+        continue;
+      }
+
+      // intersection with the rightmost parabola of the envelope, which is
+      // dropped while the new one covers it completely
+      double s;
+      while (true)
+      {
+        int p = roots[k];
+        s = ((f[q] + double(q) * q) - (f[p] + double(p) * p)) / (2.0 * (q - p));
+        if (s > bounds[k])
+          break;
+        --k;
+      }
+
+      ++k;
+      roots[k] = q;
+      bounds[k] = s;
+      bounds[k + 1] = std::numeric_limits<double>::infinity();
+    }
+
+    if (k < 0)
+    {
+      std::fill(distances + dirty_min_x_, distances + dirty_max_x_ + 1, float(max_distance_));
+      continue;
+    }
+
+    int j = 0;
+    for (int x = dirty_min_x_; x <= dirty_max_x_; ++x)
+    {
+      while (bounds[j + 1] < x)
+        ++j;
+      double d2 = double(x - roots[j]) * (x - roots[j]) + f[roots[j]];
+      distances[x] = std::min(std::sqrt(d2) * resolution_, max_distance_);
+    }
+  }
+}
+
+void DistanceTransform::runParallel(Pass pass, int begin, int end)
+{
+  int lines = end - begin + 1;
+  if (lines <= 0)
+    return;
+
+  // the calling task runs on one of the pool's threads
+  unsigned int threads = WorkerPool::instance().threadCount();
+  int helpers = std::min<int>(MAX_HELPERS, threads > 1 ? threads - 1 : 0);
+  helpers = std::min(helpers, lines / min_lines_per_chunk_ - 1);
+
+  {
+    boost::mutex::scoped_lock lock(job_mutex_);
+    job_pass_ = pass;
+    job_next_ = begin;
+    job_end_ = end;
+    job_chunk_ = std::max(min_lines_per_chunk_, lines / (4 * (std::max(helpers, 0) + 1)));
+  }
+
+  for (int h = 0; h < helpers; ++h)
+    helper_queues_[h].submit(boost::bind(&DistanceTransform::work, this));
+
+  work();
+
+  // helpers which did not start yet find no lines left, possibly during a
+  // later call, which is fine
+  boost::mutex::scoped_lock lock(job_mutex_);
+  while (job_running_)
+    job_done_.wait(lock);
+}
+
+void DistanceTransform::work()
+{
+  boost::mutex::scoped_lock lock(job_mutex_);
+  while (job_next_ <= job_end_)
+  {
+    int begin = job_next_;
+    int end = std::min(begin + job_chunk_ - 1, job_end_);
+    job_next_ = end + 1;
+    ++job_running_;
+
+    Pass pass = job_pass_;
+    lock.unlock();
+    (this->*pass)(begin, end);
+    lock.lock();
+
+    --job_running_;
+  }
+  job_done_.notify_all();
+}
+
+} // namespace octomap_rviz_plugin
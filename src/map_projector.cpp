@@ -0,0 +1,582 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Author: Julius Kammerl (jkammerl@willowgarage.com)
+ *
+ */
+
+#include "octomap_rviz_plugins/map_projector.h"
+
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace octomap_rviz_plugin
+{
+
+unsigned int MapProjector::fitDepth(const ArenaOcTree& octree, unsigned int max_depth, std::size_t fixed_bytes,
+                                    std::size_t memory_limit, std::size_t bytes_per_cell, double window_size)
+{
+  unsigned int depth = std::min<unsigned int>(max_depth, octree.getTreeDepth());
+  if (!memory_limit)
+    return depth;
+
+  double minX, minY, minZ, maxX, maxY, maxZ;
+  octree.getMetricMin(minX, minY, minZ);
+  octree.getMetricMax(maxX, maxY, maxZ);
+
+  while (depth > 1)
+  {
+    double cell_size = octree.getNodeSize(depth);
+    std::size_t cells;
+    if (window_size > 0.0)
+    {
+      std::size_t window_cells = std::max<std::size_t>(1, std::size_t(window_size / cell_size + 0.5));
+      cells = window_cells * window_cells;
+    }
+    else
+    {
+      cells = (std::size_t)((maxX-minX) / cell_size + 1) * (std::size_t)((maxY-minY) / cell_size + 1);
+    }
+    if (fixed_bytes + bytes_per_cell * cells <= memory_limit)
+      break;
+    --depth;
+  }
+
+  return depth;
+}
+
+octomap::OcTreeKey MapProjector::initGrid(const ArenaOcTree& octree, unsigned int octree_depth,
+                                          nav_msgs::OccupancyGrid& grid)
+{
+  octomap::OcTreeKey paddedMinKey = initGridInfo(octree, octree_depth, grid.info);
+
+  grid.data.clear();
+  grid.data.resize(grid.info.width * grid.info.height, -1);
+
+  return paddedMinKey;
+}
+
+octomap::OcTreeKey MapProjector::initGridInfo(const ArenaOcTree& octree, unsigned int octree_depth,
+                                              nav_msgs::MapMetaData& info)
+{
+  // get dimensions of octree
+  double minX, minY, minZ, maxX, maxY, maxZ;
+  octree.getMetricMin(minX, minY, minZ);
+  octree.getMetricMax(maxX, maxY, maxZ);
+
+  unsigned int tree_depth = octree.getTreeDepth();
+
+  octomap::OcTreeKey paddedMinKey = octree.coordToKey(minX, minY, minZ);
+
+  unsigned int width, height;
+  double res;
+
+  unsigned int ds_shift = tree_depth-octree_depth;
+
+  info.resolution = res = octree.getNodeSize(octree_depth);
+  info.width = width = (maxX-minX) / res + 1;
+  info.height = height = (maxY-minY) / res + 1;
+  info.origin.position.x = minX  - (res / (float)(1<<ds_shift) ) + res;
+  info.origin.position.y = minY  - (res / (float)(1<<ds_shift) );
+
+  return paddedMinKey;
+}
+
+void MapProjector::project(const ArenaOcTree& octree, unsigned int octree_depth, nav_msgs::OccupancyGrid& grid)
+{
+  octomap::OcTreeKey paddedMinKey = initGrid(octree, octree_depth, grid);
+  unsigned int ds_shift = octree.getTreeDepth() - octree_depth;
+  unsigned int width = grid.info.width;
+
+  // traverse all leafs in the tree:
+  unsigned int treeDepth = octree_depth;
+  for (ArenaOcTree::iterator it = octree.begin(treeDepth), end = octree.end(); it != end; ++it)
+  {
+    bool occupied = octree.isNodeOccupied(*it);
+    int intSize = 1 << (octree_depth - it.getDepth());
+
+    octomap::OcTreeKey minKey=it.getIndexKey();
+
+    for (int dx = 0; dx < intSize; dx++)
+    {
+      for (int dy = 0; dy < intSize; dy++)
+      {
+        int posX = std::max<int>(0, minKey[0] + dx - paddedMinKey[0]);
+        posX>>=ds_shift;
+
+        int posY = std::max<int>(0, minKey[1] + dy - paddedMinKey[1]);
+        posY>>=ds_shift;
+
+        int idx = width * posY + posX;
+
+        if (occupied)
+          grid.data[idx] = 100;
+        else if (grid.data[idx] == -1)
+        {
+          grid.data[idx] = 0;
+        }
+
+      }
+    }
+
+  }
+}
+
+// state of one projectBands() call
+struct SummaryProjection
+{
+  const ArenaOcTree* octree;
+  unsigned int depth;
+  unsigned int ds_shift;
+  // leaf key of the first cell, left of the tree's key range for windows
+  // reaching beyond the map
+  int origin_key[2];
+  // cells [min_x, max_x] x [min_y, max_y] which are projected, the others
+  // are left untouched
+  int region_min_x;
+  int region_min_y;
+  int region_max_x;
+  int region_max_y;
+  bool probability;
+  // grids of equal geometry and the height range of each
+  std::vector<nav_msgs::OccupancyGrid*> grids;
+  std::vector<MapProjector::ZBand> bands;
+
+  // maps hold few distinct values, binary ones only two
+  float cached_log_odds;
+  int8_t cached_value;
+};
+
+static int8_t cellValue(SummaryProjection& projection, const ArenaOcTree::Node& node)
+{
+  if (!projection.probability)
+    return projection.octree->isNodeOccupied(node) ? 100 : 0;
+
+  if (node.getLogOdds() != projection.cached_log_odds)
+  {
+    projection.cached_log_odds = node.getLogOdds();
+    projection.cached_value = static_cast<int8_t>(std::min(100.0, std::floor(100.0 * node.getOccupancy() + 0.5)));
+  }
+  return projection.cached_value;
+}
+
+// grid cells covered by a node, clipped to the projected region
+struct Footprint
+{
+  int min_x;
+  int min_y;
+  int max_x;
+  int max_y;
+};
+
+// grid cell of a key, negative left of the origin
+static int cellIndex(const SummaryProjection& projection, unsigned int key, int axis)
+{
+  int offset = int(key) - projection.origin_key[axis];
+  return offset >= 0 ? offset >> projection.ds_shift : -((-offset - 1) >> projection.ds_shift) - 1;
+}
+
+// footprint of the node at key/depth, false if it misses the region. Like
+// the leaf projection, keys left of a full grid end up in its first cell.
+static bool getFootprint(const SummaryProjection& projection, const octomap::OcTreeKey& key, unsigned int depth,
+                         Footprint& footprint)
+{
+  const ArenaOcTree& octree = *projection.octree;
+
+  octomap::OcTreeKey min_key = octree.getIndexKey(key, depth);
+  unsigned int last = (1u << (octree.getTreeDepth() - depth)) - 1;
+
+  footprint.min_x = std::max(cellIndex(projection, min_key[0], 0), projection.region_min_x);
+  footprint.min_y = std::max(cellIndex(projection, min_key[1], 1), projection.region_min_y);
+  footprint.max_x = std::min(cellIndex(projection, min_key[0] + last, 0), projection.region_max_x);
+  footprint.max_y = std::min(cellIndex(projection, min_key[1] + last, 1), projection.region_max_y);
+  return footprint.min_x <= footprint.max_x && footprint.min_y <= footprint.max_y;
+}
+
+// bands of band_mask which the node at key/depth overlaps in Z
+static uint32_t overlappingBands(const SummaryProjection& projection, const octomap::OcTreeKey& key,
+                                 unsigned int depth, uint32_t band_mask)
+{
+  double center = projection.octree->keyToCoord(key[2], depth);
+  double half_size = 0.5 * projection.octree->getNodeSize(depth);
+
+  uint32_t overlapping = 0;
+  for (std::size_t b = 0; b < projection.bands.size(); ++b)
+  {
+    const MapProjector::ZBand& band = projection.bands[b];
+    if ((band_mask & (1u << b)) && center + half_size > band.min_z && center - half_size < band.max_z)
+      overlapping |= 1u << b;
+  }
+  return overlapping;
+}
+
+static void fillFootprint(const SummaryProjection& projection, const Footprint& footprint, int8_t value,
+                          uint32_t band_mask)
+{
+  for (std::size_t b = 0; b < projection.grids.size(); ++b)
+  {
+    if (!(band_mask & (1u << b)))
+      continue;
+
+    nav_msgs::OccupancyGrid& grid = *projection.grids[b];
+
+    // unknown < free < occupied, so keeping the maximum lets occupied voxels
+    // override free ones regardless of the order
+    for (int y = footprint.min_y; y <= footprint.max_y; ++y)
+    {
+      int8_t* row = &grid.data[y * grid.info.width];
+      for (int x = footprint.min_x; x <= footprint.max_x; ++x)
+        row[x] = std::max(row[x], value);
+    }
+  }
+}
+
+// the bands of band_mask in which some cell of the footprint is below value
+static uint32_t unsettledBands(const SummaryProjection& projection, const Footprint& footprint, int8_t value,
+                               uint32_t band_mask)
+{
+  uint32_t unsettled = 0;
+  for (std::size_t b = 0; b < projection.grids.size(); ++b)
+  {
+    if (!(band_mask & (1u << b)))
+      continue;
+
+    const nav_msgs::OccupancyGrid& grid = *projection.grids[b];
+    for (int y = footprint.min_y; y <= footprint.max_y && !(unsettled & (1u << b)); ++y)
+    {
+      const int8_t* row = &grid.data[y * grid.info.width];
+      for (int x = footprint.min_x; x <= footprint.max_x; ++x)
+      {
+        if (row[x] < value)
+        {
+          unsettled |= 1u << b;
+          break;
+        }
+      }
+    }
+  }
+  return unsettled;
+}
+
+static void projectNode(SummaryProjection& projection, const ArenaOcTree::Node* node,
+                        const octomap::OcTreeKey& key, unsigned int depth, uint32_t band_mask)
+{
+  // subtrees outside of the region or of all bands are skipped
+  Footprint footprint;
+  if (!getFootprint(projection, key, depth, footprint))
+    return;
+
+  band_mask = overlappingBands(projection, key, depth, band_mask);
+  if (!band_mask)
+    return;
+
+  int8_t value = cellValue(projection, *node);
+
+  if (depth >= projection.depth || !node->hasChildren() || node->hasFlags(ArenaOcTree::FLAG_UNIFORM_FREE)
+      || node->hasFlags(ArenaOcTree::FLAG_UNIFORM_OCCUPIED))
+  {
+    fillFootprint(projection, footprint, value, band_mask);
+    return;
+  }
+
+  // inner nodes store the highest occupancy below them, so nothing in the
+  // subtree can raise cells which already reached it. Children with lower Z
+  // come first and often settle the columns for those above them.
+  band_mask = unsettledBands(projection, footprint, value, band_mask);
+  if (!band_mask)
+    return;
+
+  const ArenaOcTree& octree = *projection.octree;
+  ArenaOcTree::key_type center_offset_key = octree.getCenterOffsetKey(depth);
+  for (unsigned int i = 0; i < 8; ++i)
+  {
+    if (!node->childExists(i))
+      continue;
+
+    octomap::OcTreeKey child_key;
+    ArenaOcTree::computeChildKey(i, center_offset_key, key, child_key);
+    projectNode(projection, octree.getNodeChild(node, i), child_key, depth + 1, band_mask);
+  }
+}
+
+void MapProjector::projectSummaries(const ArenaOcTree& octree, unsigned int octree_depth, bool probability,
+                                    nav_msgs::OccupancyGrid& grid)
+{
+  std::vector<ZBand> bands(1);
+  bands[0].min_z = -std::numeric_limits<double>::infinity();
+  bands[0].max_z = std::numeric_limits<double>::infinity();
+
+  std::vector<nav_msgs::OccupancyGrid*> grids(1, &grid);
+  projectBands(octree, octree_depth, probability, bands, grids);
+}
+
+// prepares projection for the first min(bands, grids, MAX_Z_BANDS) grids,
+// which must already have the geometry of the first one
+static void initProjection(SummaryProjection& projection, const ArenaOcTree& octree, unsigned int octree_depth,
+                           bool probability, const std::vector<MapProjector::ZBand>& bands,
+                           const std::vector<nav_msgs::OccupancyGrid*>& grids)
+{
+  projection.octree = &octree;
+  projection.depth = octree_depth;
+  projection.ds_shift = octree.getTreeDepth() - octree_depth;
+  projection.probability = probability;
+  std::size_t count = std::min(std::min(bands.size(), grids.size()), std::size_t(MapProjector::MAX_Z_BANDS));
+  projection.grids.assign(grids.begin(), grids.begin() + count);
+  projection.bands.assign(bands.begin(), bands.begin() + count);
+  projection.cached_log_odds = std::numeric_limits<float>::quiet_NaN();
+  projection.cached_value = -1;
+}
+
+// projects the cells [min_x, max_x] x [min_y, max_y] of all grids
+static void projectRegion(SummaryProjection& projection, int min_x, int min_y, int max_x, int max_y)
+{
+  projection.region_min_x = min_x;
+  projection.region_min_y = min_y;
+  projection.region_max_x = max_x;
+  projection.region_max_y = max_y;
+
+  std::size_t count = projection.grids.size();
+  uint32_t all_bands = count == 32 ? 0xffffffffu : (1u << count) - 1;
+  if (projection.octree->getRoot() && min_x <= max_x && min_y <= max_y)
+    projectNode(projection, projection.octree->getRoot(), projection.octree->getRootKey(), 0, all_bands);
+}
+
+void MapProjector::projectBands(const ArenaOcTree& octree, unsigned int octree_depth, bool probability,
+                                const std::vector<ZBand>& bands, const std::vector<nav_msgs::OccupancyGrid*>& grids)
+{
+  if (grids.empty() || bands.empty())
+    return;
+
+  SummaryProjection projection;
+  initProjection(projection, octree, octree_depth, probability, bands, grids);
+
+  octomap::OcTreeKey origin_key = initGrid(octree, octree_depth, *grids.front());
+  projection.origin_key[0] = origin_key[0];
+  projection.origin_key[1] = origin_key[1];
+
+  // all bands share the geometry of the first grid
+  for (std::size_t b = 1; b < projection.grids.size(); ++b)
+  {
+    projection.grids[b]->info = grids.front()->info;
+    projection.grids[b]->data.assign(grids.front()->data.size(), -1);
+  }
+
+  const nav_msgs::MapMetaData& info = grids.front()->info;
+  projectRegion(projection, 0, 0, int(info.width) - 1, int(info.height) - 1);
+}
+
+std::size_t MapProjector::projectWindow(const ArenaOcTree& octree, unsigned int octree_depth, bool probability,
+                                        const std::vector<ZBand>& bands,
+                                        const std::vector<nav_msgs::OccupancyGrid*>& grids,
+                                        double center_x, double center_y, double size, bool shift)
+{
+  if (grids.empty() || bands.empty() || octree.empty())
+    return 0;
+
+  SummaryProjection projection;
+  initProjection(projection, octree, octree_depth, probability, bands, grids);
+
+  // cells are counted from the tree's center, which sits at key
+  // 2^(tree depth - 1), so a window cell always covers whole nodes
+  double res = octree.getNodeSize(octree_depth);
+  int center_cell = (1 << (octree.getTreeDepth() - 1)) >> projection.ds_shift;
+  int cells = std::max(1, int(size / res + 0.5));
+  int min_x = int(std::floor(center_x / res)) + center_cell - cells / 2;
+  int min_y = int(std::floor(center_y / res)) + center_cell - cells / 2;
+
+  projection.origin_key[0] = min_x << projection.ds_shift;
+  projection.origin_key[1] = min_y << projection.ds_shift;
+
+  // offset of the new window in the old one, if the grids hold one of the
+  // same geometry
+  int dx = cells, dy = cells;
+  if (shift)
+  {
+    const nav_msgs::MapMetaData& info = grids.front()->info;
+    bool same_geometry = info.resolution == float(res) && info.width == unsigned(cells)
+                         && info.height == unsigned(cells);
+    for (std::size_t b = 0; b < projection.grids.size(); ++b)
+      same_geometry = same_geometry && projection.grids[b]->data.size() == std::size_t(cells * cells);
+
+    if (same_geometry)
+    {
+      dx = min_x - (int(std::floor(info.origin.position.x / res + 0.5)) + center_cell);
+      dy = min_y - (int(std::floor(info.origin.position.y / res + 0.5)) + center_cell);
+    }
+  }
+
+  bool reuse = std::abs(dx) < cells && std::abs(dy) < cells;
+  if (reuse && !dx && !dy)
+    return 0;
+
+  for (std::size_t b = 0; b < projection.grids.size(); ++b)
+  {
+    nav_msgs::OccupancyGrid& grid = *projection.grids[b];
+    grid.info.resolution = res;
+    grid.info.width = cells;
+    grid.info.height = cells;
+    grid.info.origin.position.x = (min_x - center_cell) * res;
+    grid.info.origin.position.y = (min_y - center_cell) * res;
+
+    if (!reuse)
+    {
+      grid.data.assign(cells * cells, -1);
+      continue;
+    }
+
+    // move the cells still inside the window, the others become unknown
+    std::vector<int8_t> shifted(cells * cells, -1);
+    for (int y = std::max(0, -dy); y < std::min(cells, cells - dy); ++y)
+    {
+      const int8_t* from = &grid.data[(y + dy) * cells];
+      int8_t* to = &shifted[y * cells];
+      for (int x = std::max(0, -dx); x < std::min(cells, cells - dx); ++x)
+        to[x] = from[x + dx];
+    }
+    grid.data.swap(shifted);
+  }
+
+  if (!reuse)
+  {
+    projectRegion(projection, 0, 0, cells - 1, cells - 1);
+    return std::size_t(cells) * cells;
+  }
+
+  // the newly exposed columns over the full height, then the exposed rows
+  // of the remaining columns
+  int kept_min_x = std::max(0, -dx), kept_max_x = std::min(cells, cells - dx) - 1;
+  int kept_min_y = std::max(0, -dy), kept_max_y = std::min(cells, cells - dy) - 1;
+  std::size_t projected = 0;
+
+  if (dx)
+  {
+    int strip_min_x = dx > 0 ? kept_max_x + 1 : 0;
+    int strip_max_x = dx > 0 ? cells - 1 : kept_min_x - 1;
+    projectRegion(projection, strip_min_x, 0, strip_max_x, cells - 1);
+    projected += std::size_t(strip_max_x - strip_min_x + 1) * cells;
+  }
+  if (dy)
+  {
+    int strip_min_y = dy > 0 ? kept_max_y + 1 : 0;
+    int strip_max_y = dy > 0 ? cells - 1 : kept_min_y - 1;
+    projectRegion(projection, kept_min_x, strip_min_y, kept_max_x, strip_max_y);
+    projected += std::size_t(kept_max_x - kept_min_x + 1) * (strip_max_y - strip_min_y + 1);
+  }
+  return projected;
+}
+
+// state of one projectHeights() call
+struct HeightProjection
+{
+  const ArenaOcTree* octree;
+  unsigned int depth;
+  unsigned int ds_shift;
+  octomap::OcTreeKey origin_key;
+  MapProjector::HeightMap* map;
+};
+
+static void projectHeightNode(HeightProjection& projection, const ArenaOcTree::Node* node,
+                              const octomap::OcTreeKey& key, unsigned int depth)
+{
+  const ArenaOcTree& octree = *projection.octree;
+
+  // inner nodes store the highest occupancy below them
+  if (!octree.isNodeOccupied(*node))
+    return;
+
+  const nav_msgs::MapMetaData& info = projection.map->info;
+  octomap::OcTreeKey min_key = octree.getIndexKey(key, depth);
+  unsigned int last = (1u << (octree.getTreeDepth() - depth)) - 1;
+
+  // footprint like in the leaf projection
+  unsigned int min_x = std::max<int>(0, int(min_key[0]) - int(projection.origin_key[0])) >> projection.ds_shift;
+  unsigned int min_y = std::max<int>(0, int(min_key[1]) - int(projection.origin_key[1])) >> projection.ds_shift;
+  unsigned int max_x = std::max<int>(0, int(min_key[0] + last) - int(projection.origin_key[0])) >> projection.ds_shift;
+  unsigned int max_y = std::max<int>(0, int(min_key[1] + last) - int(projection.origin_key[1])) >> projection.ds_shift;
+  max_x = std::min(max_x, info.width - 1);
+  max_y = std::min(max_y, info.height - 1);
+
+  float top = octree.keyToCoord(key[2], depth) + 0.5 * octree.getNodeSize(depth);
+  bool fill = depth >= projection.depth || !node->hasChildren() || node->hasFlags(ArenaOcTree::FLAG_UNIFORM_OCCUPIED);
+
+  // columns which already reach the top of the node are settled, NaN
+  // compares false and keeps a column open
+  bool unsettled = false;
+  for (unsigned int y = min_y; y <= max_y; ++y)
+  {
+    float* row = &projection.map->heights[y * info.width];
+    for (unsigned int x = min_x; x <= max_x; ++x)
+    {
+      if (row[x] >= top)
+        continue;
+
+      unsettled = true;
+      if (!fill)
+        break;
+      row[x] = top;
+    }
+    if (unsettled && !fill)
+      break;
+  }
+  if (fill || !unsettled)
+    return;
+
+  // children with the Z bit set first, they often settle the columns for
+  // those below
+  ArenaOcTree::key_type center_offset_key = octree.getCenterOffsetKey(depth);
+  for (unsigned int n = 0; n < 8; ++n)
+  {
+    unsigned int i = n ^ 4;
+    if (!node->childExists(i))
+      continue;
+
+    octomap::OcTreeKey child_key;
+    ArenaOcTree::computeChildKey(i, center_offset_key, key, child_key);
+    projectHeightNode(projection, octree.getNodeChild(node, i), child_key, depth + 1);
+  }
+}
+
+void MapProjector::projectHeights(const ArenaOcTree& octree, unsigned int octree_depth, HeightMap& map)
+{
+  HeightProjection projection;
+  projection.octree = &octree;
+  projection.depth = octree_depth;
+  projection.ds_shift = octree.getTreeDepth() - octree_depth;
+  projection.origin_key = initGridInfo(octree, octree_depth, map.info);
+  projection.map = &map;
+
+  map.heights.assign(map.info.width * map.info.height, std::numeric_limits<float>::quiet_NaN());
+
+  if (octree.getRoot() && !map.heights.empty())
+    projectHeightNode(projection, octree.getRoot(), octree.getRootKey(), 0);
+}
+
+} // namespace octomap_rviz_plugin
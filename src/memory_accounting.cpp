@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "octomap_rviz_plugins/memory_accounting.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace octomap_rviz_plugin
+{
+
+MemoryAccounting::MemoryAccounting()
+{
+  reset();
+}
+
+void MemoryAccounting::set(Category category, std::size_t bytes)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+
+  current_[category] = bytes;
+  peak_[category] = std::max(peak_[category], bytes);
+
+  std::size_t sum = 0;
+  for (int i = 0; i < NUM_CATEGORIES; ++i)
+    sum += current_[i];
+
+  peak_total_ = std::max(peak_total_, sum);
+}
+
+void MemoryAccounting::reset()
+{
+  boost::mutex::scoped_lock lock(mutex_);
+
+  for (int i = 0; i < NUM_CATEGORIES; ++i)
+  {
+    current_[i] = 0;
+    peak_[i] = 0;
+  }
+  peak_total_ = 0;
+}
+
+std::size_t MemoryAccounting::current(Category category) const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return current_[category];
+}
+
+std::size_t MemoryAccounting::peak(Category category) const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return peak_[category];
+}
+
+std::size_t MemoryAccounting::total() const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+
+  std::size_t sum = 0;
+  for (int i = 0; i < NUM_CATEGORIES; ++i)
+    sum += current_[i];
+  return sum;
+}
+
+std::size_t MemoryAccounting::peakTotal() const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return peak_total_;
+}
+
+std::string MemoryAccounting::summary() const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+
+  std::stringstream ss;
+  std::size_t sum = 0;
+  for (int i = 0; i < NUM_CATEGORIES; ++i)
+  {
+    sum += current_[i];
+    if (!peak_[i])
+      continue;
+
+    ss << categoryName(static_cast<Category>(i)) << ": " << formatBytes(current_[i])
+       << " (peak " << formatBytes(peak_[i]) << "); ";
+  }
+  ss << "total: " << formatBytes(sum) << " (peak " << formatBytes(peak_total_) << ")";
+
+  return ss.str();
+}
+
+const char* MemoryAccounting::categoryName(Category category)
+{
+  switch (category)
+  {
+    case OCTREE:
+      return "octree";
+    case POINT_BUFFERS:
+      return "point buffers";
+    case RENDER_BUFFERS:
+      return "render buffers";
+    case MESSAGE_QUEUE:
+      return "message queue";
+    case OCCUPANCY_GRID:
+      return "occupancy grid";
+    default:
+      return "unknown";
+  }
+}
+
+std::string MemoryAccounting::formatBytes(std::size_t bytes)
+{
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(1);
+
+  if (bytes >= (1u << 30))
+    ss << (double)bytes / (1u << 30) << " GiB";
+  else if (bytes >= (1u << 20))
+    ss << (double)bytes / (1u << 20) << " MiB";
+  else if (bytes >= (1u << 10))
+    ss << (double)bytes / (1u << 10) << " KiB";
+  else
+    ss << bytes << " B";
+
+  return ss.str();
+}
+
+} // namespace octomap_rviz_plugin
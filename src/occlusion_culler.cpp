@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "octomap_rviz_plugins/occlusion_culler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace octomap_rviz_plugin
+{
+
+OcclusionCuller::OcclusionCuller(std::size_t width) :
+    width_(std::max<std::size_t>(width, 1)),
+    height_(1)
+{
+}
+
+void OcclusionCuller::setView(const View& view)
+{
+  view_ = view;
+  height_ = std::max<std::size_t>(1, static_cast<std::size_t>(
+      width_ * view.tan_half_fov[1] / view.tan_half_fov[0] + 0.5));
+
+  depth_.clear();
+  level_width_.clear();
+  level_height_.clear();
+  for (std::size_t w = width_, h = height_;; w = (w + 1) / 2, h = (h + 1) / 2)
+  {
+    depth_.push_back(std::vector<double>(w * h, std::numeric_limits<double>::infinity()));
+    level_width_.push_back(w);
+    level_height_.push_back(h);
+    if (w == 1 && h == 1)
+      break;
+  }
+}
+
+void OcclusionCuller::addOccluder(const double center[3], double size)
+{
+  double min[3], max[3];
+  double nearest = 0.0, farthest = 0.0;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    min[axis] = center[axis] - 0.5 * size;
+    max[axis] = center[axis] + 0.5 * size;
+
+    double below = min[axis] - view_.eye[axis];
+    double above = view_.eye[axis] - max[axis];
+    nearest += std::max(0.0, std::max(below, above)) * std::max(0.0, std::max(below, above));
+    farthest += std::max(below * below, above * above);
+  }
+
+  // the camera must draw the occluder at any orientation: it lies beyond the
+  // near clip plane even in the corners of the view and within the far one
+  double corner_scale = 1.0 + view_.tan_half_fov[0] * view_.tan_half_fov[0]
+                        + view_.tan_half_fov[1] * view_.tan_half_fov[1];
+  if (nearest < view_.near_clip * view_.near_clip * corner_scale
+      || (view_.far_clip > 0.0 && farthest > view_.far_clip * view_.far_clip))
+    return;
+
+  double u_min = std::numeric_limits<double>::max(), u_max = -u_min;
+  double v_min = u_min, v_max = -u_min;
+  for (int corner = 0; corner < 8; ++corner)
+  {
+    double point[3], view[3];
+    for (int axis = 0; axis < 3; ++axis)
+      point[axis] = (corner & (1 << axis)) ? max[axis] : min[axis];
+    toView(point, view);
+    if (view[2] <= 0.0)
+      return;
+
+    double u = 0.5 * (view[0] / (view[2] * view_.tan_half_fov[0]) + 1.0) * width_;
+    double v = 0.5 * (view[1] / (view[2] * view_.tan_half_fov[1]) + 1.0) * height_;
+    u_min = std::min(u_min, u);
+    u_max = std::max(u_max, u);
+    v_min = std::min(v_min, v);
+    v_max = std::max(v_max, v);
+  }
+
+  // texel corners within the projection, occluders covering no texel
+  // completely are skipped
+  double u_begin = std::max(0.0, std::ceil(u_min));
+  double u_end = std::min(static_cast<double>(width_), std::floor(u_max));
+  double v_begin = std::max(0.0, std::ceil(v_min));
+  double v_end = std::min(static_cast<double>(height_), std::floor(v_max));
+  if (u_end <= u_begin || v_end <= v_begin)
+    return;
+
+  std::size_t u0 = static_cast<std::size_t>(u_begin), u1 = static_cast<std::size_t>(u_end);
+  std::size_t v0 = static_cast<std::size_t>(v_begin), v1 = static_cast<std::size_t>(v_end);
+  std::size_t corners = u1 - u0 + 1;
+
+  corner_entry_.resize(corners * (v1 - v0 + 1));
+  for (std::size_t v = v0; v <= v1; ++v)
+  {
+    for (std::size_t u = u0; u <= u1; ++u)
+      corner_entry_[(v - v0) * corners + u - u0] = rayEntry(u, v, min, max);
+  }
+
+  // the projection of the box is convex, so a texel whose corners all hit
+  // the box is covered completely, and the box surface within the texel is
+  // not farther than at its farthest corner
+  std::vector<double>& depth = depth_[0];
+  for (std::size_t v = v0; v < v1; ++v)
+  {
+    const double* row = &corner_entry_[(v - v0) * corners];
+    for (std::size_t u = u0; u < u1; ++u)
+    {
+      double entry = std::max(std::max(row[u - u0], row[u - u0 + 1]),
+                              std::max(row[u - u0 + corners], row[u - u0 + corners + 1]));
+      double& texel = depth[v * width_ + u];
+      texel = std::min(texel, entry);
+    }
+  }
+}
+
+void OcclusionCuller::finishOccluders()
+{
+  for (std::size_t level = 1; level < depth_.size(); ++level)
+  {
+    const std::vector<double>& below = depth_[level - 1];
+    std::size_t below_width = level_width_[level - 1];
+    std::size_t below_height = level_height_[level - 1];
+
+    for (std::size_t y = 0; y < level_height_[level]; ++y)
+    {
+      for (std::size_t x = 0; x < level_width_[level]; ++x)
+      {
+        double depth = 0.0;
+        for (std::size_t cy = 2 * y; cy < std::min(2 * y + 2, below_height); ++cy)
+        {
+          for (std::size_t cx = 2 * x; cx < std::min(2 * x + 2, below_width); ++cx)
+            depth = std::max(depth, below[cy * below_width + cx]);
+        }
+        depth_[level][y * level_width_[level] + x] = depth;
+      }
+    }
+  }
+}
+
+bool OcclusionCuller::isBoxVisible(const double min[3], const double max[3]) const
+{
+  if (depth_.empty())
+    return true;
+
+  double u_min = std::numeric_limits<double>::max(), u_max = -u_min;
+  double v_min = u_min, v_max = -u_min;
+  double nearest = u_min;
+  for (int corner = 0; corner < 8; ++corner)
+  {
+    double point[3], view[3];
+    for (int axis = 0; axis < 3; ++axis)
+      point[axis] = (corner & (1 << axis)) ? max[axis] : min[axis];
+    toView(point, view);
+    if (view[2] <= 0.0)
+      return true;
+
+    double u = 0.5 * (view[0] / (view[2] * view_.tan_half_fov[0]) + 1.0) * width_;
+    double v = 0.5 * (view[1] / (view[2] * view_.tan_half_fov[1]) + 1.0) * height_;
+    u_min = std::min(u_min, u);
+    u_max = std::max(u_max, u);
+    v_min = std::min(v_min, v);
+    v_max = std::max(v_max, v);
+    nearest = std::min(nearest, view[2]);
+  }
+
+  if (u_min < 0.0 || v_min < 0.0 || u_max > width_ || v_max > height_)
+    return true;
+
+  // all texels touched by the projection
+  std::size_t range[4];
+  range[0] = std::min(static_cast<std::size_t>(u_min), width_ - 1);
+  range[1] = std::min(static_cast<std::size_t>(v_min), height_ - 1);
+  range[2] = std::max(range[0], std::min(static_cast<std::size_t>(std::ceil(u_max)), width_) - 1);
+  range[3] = std::max(range[1], std::min(static_cast<std::size_t>(std::ceil(v_max)), height_) - 1);
+
+  return isRangeVisible(depth_.size() - 1, 0, 0, range, nearest);
+}
+
+void OcclusionCuller::toView(const double point[3], double view[3]) const
+{
+  double offset[3];
+  for (int axis = 0; axis < 3; ++axis)
+    offset[axis] = point[axis] - view_.eye[axis];
+
+  view[0] = offset[0] * view_.right[0] + offset[1] * view_.right[1] + offset[2] * view_.right[2];
+  view[1] = offset[0] * view_.up[0] + offset[1] * view_.up[1] + offset[2] * view_.up[2];
+  view[2] = offset[0] * view_.forward[0] + offset[1] * view_.forward[1] + offset[2] * view_.forward[2];
+}
+
+double OcclusionCuller::rayEntry(std::size_t u, std::size_t v, const double min[3], const double max[3]) const
+{
+  // the ray advances by one along forward per unit, so the ray parameter is
+  // the view distance
+  double a = view_.tan_half_fov[0] * (2.0 * u / width_ - 1.0);
+  double b = view_.tan_half_fov[1] * (2.0 * v / height_ - 1.0);
+
+  double enter = 0.0;
+  double exit = std::numeric_limits<double>::infinity();
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    double direction = view_.forward[axis] + a * view_.right[axis] + b * view_.up[axis];
+    if (direction == 0.0)
+    {
+      if (view_.eye[axis] < min[axis] || view_.eye[axis] > max[axis])
+        return std::numeric_limits<double>::infinity();
+      continue;
+    }
+
+    double t0 = (min[axis] - view_.eye[axis]) / direction;
+    double t1 = (max[axis] - view_.eye[axis]) / direction;
+    enter = std::max(enter, std::min(t0, t1));
+    exit = std::min(exit, std::max(t0, t1));
+  }
+
+  return enter <= exit ? enter : std::numeric_limits<double>::infinity();
+}
+
+bool OcclusionCuller::isRangeVisible(std::size_t level, std::size_t x, std::size_t y, const std::size_t range[4],
+                                     double depth) const
+{
+  // the maximum of all texels below is in front of the box
+  if (depth_[level][y * level_width_[level] + x] < depth)
+    return false;
+  if (level == 0)
+    return true;
+
+  std::size_t child_level = level - 1;
+  std::size_t span = static_cast<std::size_t>(1) << child_level;
+  for (std::size_t cy = 2 * y; cy < std::min(2 * y + 2, level_height_[child_level]); ++cy)
+  {
+    if ((cy + 1) * span <= range[1] || cy * span > range[3])
+      continue;
+
+    for (std::size_t cx = 2 * x; cx < std::min(2 * x + 2, level_width_[child_level]); ++cx)
+    {
+      if ((cx + 1) * span <= range[0] || cx * span > range[2])
+        continue;
+      if (isRangeVisible(child_level, cx, cy, range, depth))
+        return true;
+    }
+  }
+
+  return false;
+}
+
+} // namespace octomap_rviz_plugin
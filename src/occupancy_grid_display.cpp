@@ -36,19 +36,34 @@
 #include <boost/bind.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <OGRE/OgreAxisAlignedBox.h>
 #include <OGRE/OgreSceneNode.h>
 #include <OGRE/OgreSceneManager.h>
+#include <OGRE/OgreCamera.h>
+#include <OGRE/OgreViewport.h>
 
 #include "rviz/visualization_manager.h"
 #include "rviz/frame_manager.h"
+#include "rviz/view_controller.h"
+#include "rviz/view_manager.h"
+#include "rviz/properties/bool_property.h"
+#include "rviz/properties/float_property.h"
 #include "rviz/properties/int_property.h"
 #include "rviz/properties/ros_topic_property.h"
 #include "rviz/properties/enum_property.h"
+#include "rviz/properties/string_property.h"
+#include "rviz/properties/tf_frame_property.h"
 
-#include <octomap/octomap.h>
 #include <octomap_msgs/Octomap.h>
-#include <octomap_msgs/conversions.h>
 
+#include "octomap_rviz_plugins/allocation_counter.h"
+#include "octomap_rviz_plugins/morton.h"
+#include "octomap_rviz_plugins/occlusion_culler.h"
+#include "octomap_rviz_plugins/tracing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <sstream>
 
 using namespace rviz;
@@ -58,25 +73,113 @@ namespace octomap_rviz_plugin
 
 static const std::size_t max_octree_depth_ = sizeof(unsigned short) * 8;
 
+// estimated size of a vertex in the Ogre vertex buffers (position, texture
+// coordinates and color)
+static const std::size_t bytes_per_vertex_ = 6 * sizeof(float) + sizeof(uint32_t);
+
+// estimated size of a single box (36 vertices) plus the copy kept by
+// rviz::PointCloud, the most expensive render style
+static const std::size_t render_bytes_per_point_ = 36 * bytes_per_vertex_ + sizeof(rviz::PointCloud::Point);
+
+// smallest projected voxel size in pixels rendered as boxes and flat squares
+// in "Auto" style, promotions additionally need the hysteresis factor so that
+// zooming around a threshold does not rebuild the clouds every frame
+static const double box_min_pixels_ = 4.0;
+static const double square_min_pixels_ = 1.0;
+static const double style_hysteresis_ = 1.25;
+
+// progressive refinement splits the map into at least this many regions, if
+// the preview depth allows
+static const std::size_t min_refinement_regions_ = 64;
+
 enum OctreeVoxelRenderMode
 {
   OCTOMAP_FREE_VOXELS = 1,
   OCTOMAP_OCCUPIED_VOXELS = 2
 };
 
+// render mode bit selecting a voxel set
+static int voxelSetMask(int set)
+{
+  return set == VoxelExtractor::OCCUPIED_SET ? OCTOMAP_OCCUPIED_VOXELS : OCTOMAP_FREE_VOXELS;
+}
+
 enum OctreeVoxelColorMode
 {
   OCTOMAP_Z_AXIS_COLOR,
   OCTOMAP_PROBABLILTY_COLOR,
 };
 
+enum OctreeTransformTime
+{
+  OCTOMAP_MESSAGE_STAMP,
+  OCTOMAP_LATEST_TRANSFORM
+};
+
+// render styles besides the rviz::PointCloud render modes
+enum OctreeVoxelRenderStyle
+{
+  OCTOMAP_AUTO_STYLE = -1
+};
+
+static std::size_t verticesPerPoint(int style)
+{
+  switch (style)
+  {
+    case rviz::PointCloud::RM_BOXES:
+      return 36;
+    case rviz::PointCloud::RM_FLAT_SQUARES:
+      return 6;
+    default:
+      return 1;
+  }
+}
+
+// cheapest style worth using for voxels of the given projected size
+static int autoRenderStyle(double pixels, int current)
+{
+  double box_pixels = box_min_pixels_;
+  if (current != rviz::PointCloud::RM_BOXES)
+    box_pixels *= style_hysteresis_;
+
+  double square_pixels = square_min_pixels_;
+  if (current == rviz::PointCloud::RM_POINTS)
+    square_pixels *= style_hysteresis_;
+
+  if (pixels >= box_pixels)
+    return rviz::PointCloud::RM_BOXES;
+  if (pixels >= square_pixels)
+    return rviz::PointCloud::RM_FLAT_SQUARES;
+  return rviz::PointCloud::RM_POINTS;
+}
+
+// whether the results of an occlusion pass queued for view apply to current
+static bool viewMatches(const OcclusionCuller::View& current, const OcclusionCuller::View& view, double tolerance)
+{
+  double moved_squared = 0.0;
+  for (int axis = 0; axis < 3; ++axis)
+    moved_squared += (current.eye[axis] - view.eye[axis]) * (current.eye[axis] - view.eye[axis]);
+  return moved_squared <= tolerance * tolerance && current.tan_half_fov[0] == view.tan_half_fov[0]
+         && current.tan_half_fov[1] == view.tan_half_fov[1] && current.near_clip == view.near_clip
+         && current.far_clip == view.far_clip;
+}
+
+static std::size_t centerBytes(const std::vector<std::vector<Ogre::Vector3> >* centers)
+{
+  std::size_t bytes = 0;
+  for (size_t i = 0; centers && i < centers->size(); ++i)
+    bytes += (*centers)[i].capacity() * sizeof(Ogre::Vector3);
+  return bytes;
+}
+
 OccupancyGridDisplay::OccupancyGridDisplay() :
     rviz::Display(),
-    new_points_received_(false),
     messages_received_(0),
     queue_size_(5),
     color_factor_(0.8),
-    octree_depth_(0)
+    octree_depth_(0),
+    camera_position_(Ogre::Vector3::ZERO),
+    camera_orientation_(Ogre::Quaternion::IDENTITY)
 {
 
   octomap_topic_property_ = new RosTopicProperty( "Octomap Topic",
@@ -112,42 +215,206 @@ OccupancyGridDisplay::OccupancyGridDisplay() :
   octree_coloring_property_->addOption( "Z-Axis",  OCTOMAP_Z_AXIS_COLOR );
   octree_coloring_property_->addOption( "Cell Probability",  OCTOMAP_PROBABLILTY_COLOR );
 
+  merge_tolerance_property_ = new FloatProperty("Merge Tolerance",
+                                                0.0,
+                                                "Show subtrees of up to 8x8x8 voxels of the same kind as a single "
+                                                "voxel if their colors differ by at most this fraction of the color "
+                                                "range. 0 shows every voxel.",
+                                                octree_coloring_property_,
+                                                SLOT (updateMergeTolerance() ),
+                                                this);
+  merge_tolerance_property_->setMin(0.0);
+  merge_tolerance_property_->setMax(1.0);
+
   tree_depth_property_ = new IntProperty("Max. Octree Depth",
                                          max_octree_depth_,
                                          "Defines the maximum tree depth",
                                          this,
                                          SLOT (updateTreeDepth() ));
   tree_depth_property_->setMin(0);
+
+  memory_limit_property_ = new IntProperty("Memory Limit (MB)",
+                                           0,
+                                           "Upper bound for the memory used by this display. If a map would exceed it, "
+                                           "the octree depth is reduced until it fits. 0 disables the limit.",
+                                           this,
+                                           SLOT (updateMemoryLimit() ));
+  memory_limit_property_->setMin(0);
+
+  max_voxels_property_ = new IntProperty("Max Voxels",
+                                         0,
+                                         "Upper bound for the voxels shown per voxel set. Voxels nearest to the "
+                                         "focus frame are extracted first and extraction stops at the bound, so "
+                                         "its cost does not grow with the map size. 0 shows all voxels.",
+                                         this,
+                                         SLOT (updateVoxelBudget() ));
+  max_voxels_property_->setMin(0);
+
+  focus_frame_property_ = new TfFrameProperty("Focus Frame",
+                                              TfFrameProperty::FIXED_FRAME_STRING,
+                                              "Frame whose origin is shown in full detail when Max Voxels is set.",
+                                              max_voxels_property_,
+                                              NULL,
+                                              true,
+                                              SLOT (updateVoxelBudget() ),
+                                              this);
+
+  progressive_depth_property_ = new IntProperty("Progressive Depth",
+                                                0,
+                                                "Show new maps up to this depth first and refine them region by "
+                                                "region, so large maps appear quickly. 0 shows maps only once they "
+                                                "are fully extracted.",
+                                                this,
+                                                SLOT (updateTreeDepth() ));
+  progressive_depth_property_->setMin(0);
+
+  record_file_property_ = new StringProperty("Record File",
+                                             "",
+                                             "Advanced: append every received message together with the current "
+                                             "view to this file for octomap_replay_benchmark. Empty disables recording.",
+                                             this,
+                                             SLOT (updateRecordFile() ));
+
+  worker_threads_property_ = new IntProperty("Worker Threads",
+                                             0,
+                                             "Advanced: number of threads decoding maps for all octomap displays. "
+                                             "The pool is shared, the last value set applies. 0 uses one thread "
+                                             "less than the number of cores.",
+                                             this,
+                                             SLOT (updateWorkerThreads() ));
+  worker_threads_property_->setMin(0);
+
+  transform_time_property_ = new rviz::EnumProperty( "Transform Time", "Message Stamp",
+                                                     "Time at which the map frame is looked up every frame. Latest "
+                                                     "follows a map frame moving between messages.",
+                                                     this,
+                                                     SLOT( updateTransformTime() ) );
+
+  transform_time_property_->addOption( "Message Stamp",  OCTOMAP_MESSAGE_STAMP );
+  transform_time_property_->addOption( "Latest",  OCTOMAP_LATEST_TRANSFORM );
+
+  render_style_property_ = new rviz::EnumProperty( "Render Style", "Boxes",
+                                                   "Select how voxels are drawn. Auto picks boxes, flat squares or "
+                                                   "points per depth from the on-screen voxel size and the vertex budget.",
+                                                   this,
+                                                   SLOT( updateRenderStyle() ) );
+
+  render_style_property_->addOption( "Boxes",  rviz::PointCloud::RM_BOXES );
+  render_style_property_->addOption( "Flat Squares",  rviz::PointCloud::RM_FLAT_SQUARES );
+  render_style_property_->addOption( "Points",  rviz::PointCloud::RM_POINTS );
+  render_style_property_->addOption( "Auto",  OCTOMAP_AUTO_STYLE );
+
+  vertex_budget_property_ = new IntProperty("Vertex Budget",
+                                            10000000,
+                                            "Number of vertices per frame the Auto render style aims for. Coarse "
+                                            "depths are served first, finer depths fall back to cheaper styles.",
+                                            render_style_property_,
+                                            SLOT (updateRenderStyle() ),
+                                            this);
+  vertex_budget_property_->setMin(0);
+
+  occlusion_property_ = new BoolProperty("Occlusion Culling",
+                                         false,
+                                         "Hide chunks of voxels which the occupied voxels drawn as boxes cover "
+                                         "completely. Tested on a worker thread whenever the camera or the voxels "
+                                         "changed, all chunks are shown meanwhile.",
+                                         this,
+                                         SLOT (updateOcclusionCulling() ));
+
+  slice_property_ = new BoolProperty("Slice",
+                                     false,
+                                     "Only show voxels intersecting a horizontal slab of the map.",
+                                     this,
+                                     SLOT (updateSlice() ));
+
+  slice_height_property_ = new FloatProperty("Slice Height",
+                                             0.0,
+                                             "Height of the slab center in the map frame.",
+                                             slice_property_,
+                                             SLOT (updateSlice() ),
+                                             this);
+
+  slice_thickness_property_ = new FloatProperty("Slice Thickness",
+                                                0.2,
+                                                "Thickness of the slab.",
+                                                slice_property_,
+                                                SLOT (updateSlice() ),
+                                                this);
+  slice_thickness_property_->setMin(0.0);
+
+  slice_changed_ = false;
+  render_style_changed_ = false;
+  transform_ok_ = true;
+  occlusion_slice_ = false;
+  occlusion_slice_min_ = 0.0;
+  occlusion_slice_max_ = 0.0;
+  occlusion_tolerance_ = 0.0;
+  occlusion_view_ = OcclusionCuller::View();
+  occlusion_applied_view_ = OcclusionCuller::View();
+  occlusion_pending_ = false;
+  occlusion_ready_ = false;
+  occlusion_active_ = false;
+  occlusion_hiding_ = false;
+  for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+  {
+    voxel_set_extracted_[set] = false;
+    voxel_set_bytes_[set] = 0;
+    new_points_received_[set] = false;
+    progressive_uploaded_[set] = false;
+    refining_[set] = false;
+    voxel_set_node_[set] = NULL;
+  }
+
+  for (int i = 0; i < 3; ++i)
+    focus_[i] = 0.0;
 }
 
 void OccupancyGridDisplay::onInitialize()
 {
+  focus_frame_property_->setFrameManager(context_->getFrameManager());
+
   boost::mutex::scoped_lock lock(mutex_);
 
   box_size_.resize(max_octree_depth_);
-  cloud_.resize(max_octree_depth_);
-  point_buf_.resize(max_octree_depth_);
-  new_points_.resize(max_octree_depth_);
 
-  for (std::size_t i = 0; i < max_octree_depth_; ++i)
+  for (int set = 0; set < NUM_VOXEL_SETS; ++set)
   {
-    std::stringstream sname;
-    sname << "PointCloud Nr." << i;
-    cloud_[i] = new rviz::PointCloud();
-    cloud_[i]->setName(sname.str());
-    cloud_[i]->setRenderMode(rviz::PointCloud::RM_BOXES);
-    scene_node_->attachObject(cloud_[i]);
+    cloud_[set].resize(max_octree_depth_);
+    point_buf_[set].resize(max_octree_depth_);
+    new_points_[set].resize(max_octree_depth_);
+    shown_points_[set].resize(max_octree_depth_);
+    layer_buf_[set].resize(max_octree_depth_);
+    new_layers_[set].resize(max_octree_depth_);
+    shown_layers_[set].resize(max_octree_depth_);
+    slice_points_[set].resize(max_octree_depth_);
+
+    CloudExtent empty;
+    empty.points = 0;
+    cloud_extent_[set].resize(max_octree_depth_, empty);
+    cloud_style_[set].resize(max_octree_depth_, rviz::PointCloud::RM_BOXES);
+    applied_style_[set].resize(max_octree_depth_, rviz::PointCloud::RM_BOXES);
+
+    // point clouds are only created for depths which contain voxels
+    voxel_set_node_[set] = scene_node_->createChildSceneNode();
   }
+
+  updateVoxelSetVisibility();
 }
 
 OccupancyGridDisplay::~OccupancyGridDisplay()
 {
-  std::size_t i;
-
   unsubscribe();
 
-  for (std::vector<rviz::PointCloud*>::iterator it = cloud_.begin(); it != cloud_.end(); ++it) {
-    delete *(it);
+  for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+  {
+    for (size_t i = 0; i < cloud_[set].size(); ++i)
+      destroyCloud(set, i);
+
+    if (voxel_set_node_[set])
+    {
+      voxel_set_node_[set]->detachAllObjects();
+      scene_manager_->destroySceneNode(voxel_set_node_[set]);
+    }
   }
 
   if (scene_node_)
@@ -164,6 +431,7 @@ void OccupancyGridDisplay::updateQueueSize()
 void OccupancyGridDisplay::onEnable()
 {
   scene_node_->setVisible(true);
+  updateVoxelSetVisibility();
   subscribe();
 }
 
@@ -207,11 +475,10 @@ void OccupancyGridDisplay::subscribe()
 
 void OccupancyGridDisplay::unsubscribe()
 {
-  clear();
-
   try
   {
-    // reset filters
+    // reset filters first, the subscriber waits for a running callback, so
+    // no message queues a new task while the state below is cleared
     sub_.reset();
   }
   catch (ros::Exception& e)
@@ -219,58 +486,67 @@ void OccupancyGridDisplay::unsubscribe()
     setStatus(StatusProperty::Error, "Topic", (std::string("Error unsubscribing: ") + e.what()).c_str());
   }
 
+  work_queue_.cancel();
+  {
+    boost::mutex::scoped_lock lock(pending_mutex_);
+    pending_messages_.clear();
+  }
+  updateQueueStatus();
+
+  clear();
 }
 
-// method taken from octomap_server package
-void OccupancyGridDisplay::setColor(double z_pos, double min_z, double max_z, double color_factor,
-                                    rviz::PointCloud::Point& point)
-{
-  int i;
-  double m, n, f;
-
-  double s = 1.0;
-  double v = 1.0;
-
-  double h = (1.0 - std::min(std::max((z_pos - min_z) / (max_z - min_z), 0.0), 1.0)) * color_factor;
-
-  h -= floor(h);
-  h *= 6;
-  i = floor(h);
-  f = h - i;
-  if (!(i & 1))
-    f = 1 - f; // if i is even
-  m = v * (1 - s);
-  n = v * (1 - s * f);
-
-  switch (i)
-  {
-    case 6:
-    case 0:
-      point.setColor(v, n, m);
-      break;
-    case 1:
-      point.setColor(n, v, m);
-      break;
-    case 2:
-      point.setColor(m, v, n);
-      break;
-    case 3:
-      point.setColor(m, n, v);
-      break;
-    case 4:
-      point.setColor(n, m, v);
-      break;
-    case 5:
-      point.setColor(v, m, n);
-      break;
-    default:
-      point.setColor(1, 0.5, 0.5);
-      break;
+void OccupancyGridDisplay::incomingMessageCallback(const octomap_msgs::OctomapConstPtr& msg)
+{
+  TraceScope trace("receive");
+
+  {
+    // like the subscriber queue, drop the oldest messages if decoding falls behind
+    boost::mutex::scoped_lock lock(pending_mutex_);
+    pending_messages_.push_back(msg);
+    while (pending_messages_.size() > queue_size_)
+      pending_messages_.pop_front();
   }
+
+  work_queue_.submit(boost::bind(&OccupancyGridDisplay::processPendingMessage, this));
+  updateQueueStatus();
 }
 
-void OccupancyGridDisplay::incomingMessageCallback(const octomap_msgs::OctomapConstPtr& msg)
+void OccupancyGridDisplay::processPendingMessage()
+{
+  octomap_msgs::OctomapConstPtr msg;
+  {
+    boost::mutex::scoped_lock lock(pending_mutex_);
+
+    // the message of this task may have been dropped
+    if (pending_messages_.empty())
+      return;
+
+    msg = pending_messages_.front();
+    pending_messages_.pop_front();
+  }
+
+  processMessage(msg);
+  updateQueueStatus();
+}
+
+void OccupancyGridDisplay::updateQueueStatus()
+{
+  std::size_t pending;
+  {
+    boost::mutex::scoped_lock lock(pending_mutex_);
+    pending = pending_messages_.size();
+  }
+
+  std::stringstream ss;
+  ss << pending << " messages pending, " << WorkerPool::instance().threadCount() << " shared worker threads";
+  setStatusStd(StatusProperty::Ok, "Queue", ss.str());
+}
+
+void OccupancyGridDisplay::processMessage(const octomap_msgs::OctomapConstPtr& msg)
 {
+  TraceScope trace("process");
+
   ++messages_received_;
   setStatus(StatusProperty::Ok, "Messages", QString::number(messages_received_) + " octomap messages received");
 
@@ -279,7 +555,7 @@ void OccupancyGridDisplay::incomingMessageCallback(const octomap_msgs::OctomapCo
   // get tf transform
   Ogre::Vector3 pos;
   Ogre::Quaternion orient;
-  if (!context_->getFrameManager()->getTransform(msg->header, pos, orient))
+  if (!getFrameTransform(msg->header.frame_id, msg->header.stamp, pos, orient))
   {
     std::stringstream ss;
     ss << "Failed to transform from frame [" << msg->header.frame_id << "] to frame ["
@@ -288,183 +564,1346 @@ void OccupancyGridDisplay::incomingMessageCallback(const octomap_msgs::OctomapCo
     return;
   }
 
-  scene_node_->setOrientation(orient);
-  scene_node_->setPosition(pos);
+  {
+    // the scene node is moved by the render thread
+    boost::mutex::scoped_lock lock(mutex_);
+    map_frame_ = msg->header.frame_id;
+    map_stamp_ = msg->header.stamp;
+  }
+
+  recordMessage(*msg, pos, orient);
+
+  boost::mutex::scoped_lock tree_lock(octree_mutex_);
+
+  for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+    voxel_set_extracted_[set] = false;
 
-  // creating octree
-  octomap::OcTree* octomap = NULL;
-  octomap::AbstractOcTree* tree = octomap_msgs::msgToMap(*msg);
-  if (tree){
-    octomap = dynamic_cast<octomap::OcTree*>(tree);
+  // decoding octree into the reused node arena
+  AllocationCounter::Counts decode_allocations;
+  bool decoded;
+  {
+    TraceScope trace("decode");
+    AllocationScope allocations(decode_allocations);
+    decoded = octree_.readMessage(*msg);
   }
 
-  if (!octomap)
+  if (!decoded)
   {
     this->setStatusStd(StatusProperty::Error, "Message", "Failed to create octree structure");
     return;
   }
 
-  std::size_t octree_depth = octomap->getTreeDepth();
-  tree_depth_property_->setMax(octomap->getTreeDepth());
-  
+  tree_depth_property_->setMax(octree_.getTreeDepth());
 
-  // get dimensions of octree
-  double minX, minY, minZ, maxX, maxY, maxZ;
-  octomap->getMetricMin(minX, minY, minZ);
-  octomap->getMetricMax(maxX, maxY, maxZ);
+  memory_.set(MemoryAccounting::OCTREE, octree_.memoryUsage());
+  memory_.set(MemoryAccounting::MESSAGE_QUEUE, msg->data.size() * queue_size_);
 
   // reset rviz pointcloud classes
   for (std::size_t i = 0; i < max_octree_depth_; ++i)
   {
-    point_buf_[i].clear();
-    box_size_[i] = octomap->getNodeSize(i + 1);
+    box_size_[i] = octree_.getNodeSize(i + 1);
+  }
+
+  updateFocus(msg->header.frame_id, msg->header.stamp);
+
+  // only extract the sets currently shown, the others are built when the
+  // render mode changes
+  AllocationCounter::Counts extract_allocations;
+  int render_mode_mask = octree_render_property_->getOptionInt();
+  for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+  {
+    if (voxelSetMask(set) & render_mode_mask)
+    {
+      AllocationScope allocations(extract_allocations);
+      extractVoxelSet(static_cast<VoxelSet>(set));
+    }
+    else
+    {
+      dropVoxelSet(static_cast<VoxelSet>(set));
+    }
+  }
+
+  updatePointBufferMemory();
+  updateMemoryStatus();
+
+  // only reported if the counting allocator hook is preloaded
+  if (AllocationCounter::available())
+  {
+    setStatusStd(StatusProperty::Ok, "Allocations", "decode: " + AllocationCounter::format(decode_allocations) +
+                 ", extraction: " + AllocationCounter::format(extract_allocations));
+  }
+}
+
+void OccupancyGridDisplay::dropVoxelSet(VoxelSet set)
+{
+  voxel_set_extracted_[set] = false;
+  voxel_set_bytes_[set] = 0;
+
+  boost::mutex::scoped_lock lock(mutex_);
+
+  for (size_t i = 0; i < max_octree_depth_; ++i)
+  {
+    new_points_[set][i].clear();
+    new_layers_[set][i].clear();
+  }
+  if (set == VoxelExtractor::OCCUPIED_SET)
+    new_centers_.reset();
+  new_points_received_[set] = true;
+}
+
+void OccupancyGridDisplay::extractVoxelSet(VoxelSet set)
+{
+  // translate the memory limit into a maximum number of voxels
+  std::size_t max_points = std::numeric_limits<std::size_t>::max();
+  std::size_t memory_limit = static_cast<std::size_t>(memory_limit_property_->getInt()) << 20;
+  bool build_centers = set == VoxelExtractor::OCCUPIED_SET && occlusion_property_->getBool();
+  std::size_t bytes_per_point = 3 * sizeof(PointCloud::Point) + sizeof(uint32_t) + VoxelExtractor::bytesPerVoxel()
+                                + render_bytes_per_point_ + (build_centers ? 2 * sizeof(Ogre::Vector3) : 0);
+  if (memory_limit)
+  {
+    // sets extracted before keep their buffers, what is left is split between
+    // this set and the other shown sets still to extract
+    std::size_t fixed_bytes = memory_.current(MemoryAccounting::OCTREE) + memory_.current(MemoryAccounting::MESSAGE_QUEUE);
+    std::size_t pending_sets = 0;
+    int render_mode_mask = octree_render_property_->getOptionInt();
+    for (int other = 0; other < NUM_VOXEL_SETS; ++other)
+    {
+      if (other != set && voxel_set_extracted_[other])
+        fixed_bytes += voxel_set_bytes_[other];
+      else if (other == set || (voxelSetMask(other) & render_mode_mask))
+        ++pending_sets;
+    }
+    max_points = fixed_bytes < memory_limit ? (memory_limit - fixed_bytes) / pending_sets / bytes_per_point : 0;
   }
 
+  unsigned int requested_depth = std::min<unsigned int>(tree_depth_property_->getInt(), octree_.getTreeDepth());
+  unsigned int treeDepth = requested_depth;
   size_t pointCount = 0;
+
+  extractor_.setColorMode(static_cast<VoxelExtractor::ColorMode>(octree_coloring_property_->getOptionInt()));
+  extractor_.setColorFactor(color_factor_);
+  extractor_.setMergeTolerance(merge_tolerance_property_->getFloat());
+
+  std::string budget_status = std::string(set == VoxelExtractor::OCCUPIED_SET ? "Occupied" : "Free") + " Voxel Budget";
+  std::size_t max_voxels = max_voxels_property_->getInt();
+  unsigned int progressive_depth = progressive_depth_property_->getInt();
+  bool progressive = false;
+  if (max_voxels)
   {
-    // traverse all leafs in the tree:
-    unsigned int treeDepth = std::min<unsigned int>(tree_depth_property_->getInt(), octomap->getTreeDepth());
-    for (octomap::OcTree::iterator it = octomap->begin(treeDepth), end = octomap->end(); it != end; ++it)
+    // the budget bounds the extraction, no need to reduce the depth
+    if (extractor_.extractNearest(octree_, set, requested_depth, focus_, std::min(max_voxels, max_points),
+                                  point_buf_[set], pointCount))
+    {
+      deleteStatusStd(budget_status);
+    }
+    else
     {
+      std::stringstream ss;
+      ss << "Showing the " << pointCount << " voxels nearest to [" << focus_frame_property_->getFrameStd() << "]";
+      setStatusStd(StatusProperty::Ok, budget_status, ss.str());
+    }
+  }
+  else if (progressive_depth && progressive_depth < requested_depth && !slice_property_->getBool()
+           && extractProgressively(set, progressive_depth, requested_depth, max_points, pointCount))
+  {
+    deleteStatusStd(budget_status);
+    progressive = true;
+  }
+  else
+  {
+    deleteStatusStd(budget_status);
 
-      if (octomap->isNodeOccupied(*it))
-      {
+    // degrade gracefully by reducing the tree depth until the voxels fit
+    while (!extractor_.extract(octree_, set, treeDepth,
+                               treeDepth > 1 ? max_points : std::numeric_limits<std::size_t>::max(),
+                               point_buf_[set], pointCount))
+    {
+      --treeDepth;
+    }
+  }
 
-        int render_mode_mask = octree_render_property_->getOptionInt();
+  if (treeDepth < requested_depth)
+  {
+    std::stringstream ss;
+    ss << "Reduced octree depth from " << requested_depth << " to " << treeDepth << " to stay within "
+       << MemoryAccounting::formatBytes(memory_limit);
+    this->setStatusStd(StatusProperty::Warn, "Memory Limit", ss.str());
+  }
+  else
+  {
+    deleteStatusStd("Memory Limit");
+  }
 
-        bool display_voxel = false;
+  // bucket the voxels by height so slices are selected without a full scan
+  for (size_t i = 0; i < max_octree_depth_; ++i)
+    layer_buf_[set][i].build(point_buf_[set][i], box_size_[i]);
 
-        // the left part evaluates to 1 for free voxels and 2 for occupied voxels
-        if (((int)octomap->isNodeOccupied(*it) + 1) & render_mode_mask)
-        {
-          // check if current voxel has neighbors on all sides -> no need to be displayed
-          bool allNeighborsFound = true;
-
-          octomap::OcTreeKey key;
-          octomap::OcTreeKey nKey = it.getKey();
-
-          for (key[2] = nKey[2] - 1; allNeighborsFound && key[2] <= nKey[2] + 1; ++key[2])
-          {
-            for (key[1] = nKey[1] - 1; allNeighborsFound && key[1] <= nKey[1] + 1; ++key[1])
-            {
-              for (key[0] = nKey[0] - 1; allNeighborsFound && key[0] <= nKey[0] + 1; ++key[0])
-              {
-                if (key != nKey)
-                {
-                  octomap::OcTreeNode* node = octomap->search(key);
-
-                  // the left part evaluates to 1 for free voxels and 2 for occupied voxels
-                  if (!(node && (((int)octomap->isNodeOccupied(node)) + 1) & render_mode_mask))
-                  {
-                    // we do not have a neighbor => break!
-                    allNeighborsFound = false;
-                  }
-                }
-              }
-            }
-          }
-
-          display_voxel |= !allNeighborsFound;
-        }
+  // occluders of the occlusion culling, shared with the passes from here on
+  VVCenterConstPtr centers;
+  if (build_centers)
+  {
+    boost::shared_ptr<VVCenter> built(new VVCenter(max_octree_depth_));
+    for (size_t i = 0; i < max_octree_depth_; ++i)
+    {
+      const VPoint& points = point_buf_[set][i];
+      (*built)[i].resize(points.size());
+      for (size_t k = 0; k < points.size(); ++k)
+        (*built)[i][k] = points[k].position;
+    }
+    centers = built;
+  }
 
+  {
+    // includes waiting for the render thread
+    TraceScope trace("handoff");
 
-        if (display_voxel)
-        {
-          PointCloud::Point newPoint;
-
-          newPoint.position.x = it.getX();
-          newPoint.position.y = it.getY();
-          newPoint.position.z = it.getZ();
-
-          float cell_probability;
-
-          OctreeVoxelColorMode octree_color_mode = static_cast<OctreeVoxelColorMode>(octree_coloring_property_->getOptionInt());
-
-          switch (octree_color_mode)
-          {
-            case OCTOMAP_Z_AXIS_COLOR:
-              setColor(newPoint.position.z, minZ, maxZ, color_factor_, newPoint);
-              break;
-            case OCTOMAP_PROBABLILTY_COLOR:
-              cell_probability = it->getOccupancy();
-              newPoint.setColor((1.0f-cell_probability), cell_probability, 0.0);
-              break;
-            default:
-              break;
-          }
-
-          // push to point vectors
-          unsigned int depth = it.getDepth();
-          point_buf_[depth - 1].push_back(newPoint);
-
-          ++pointCount;
-        }
-      }
+    boost::mutex::scoped_lock lock(mutex_);
+
+    new_points_received_[set] = true;
+    progressive_uploaded_[set] = progressive;
+    if (set == VoxelExtractor::OCCUPIED_SET)
+      new_centers_ = centers;
+
+    for (size_t i = 0; i < max_octree_depth_; ++i)
+    {
+      new_points_[set][i].swap(point_buf_[set][i]);
+      new_layers_[set][i].swap(layer_buf_[set][i]);
+    }
+  }
+
+  voxel_set_extracted_[set] = true;
+  voxel_set_bytes_[set] = pointCount * bytes_per_point;
+}
+
+void OccupancyGridDisplay::updatePointBufferMemory()
+{
+  boost::mutex::scoped_lock lock(mutex_);
+
+  std::size_t point_bytes = extractor_.memoryUsage();
+  for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+  {
+    for (size_t i = 0; i < point_buf_[set].size(); ++i)
+    {
+      point_bytes += (point_buf_[set][i].capacity() + new_points_[set][i].capacity()
+                      + shown_points_[set][i].capacity()) * sizeof(PointCloud::Point);
+      point_bytes += layer_buf_[set][i].memoryUsage() + new_layers_[set][i].memoryUsage()
+                     + shown_layers_[set][i].memoryUsage();
     }
   }
+  for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+  {
+    for (size_t i = 0; i < slice_points_[set].size(); ++i)
+      point_bytes += slice_points_[set][i].capacity() * sizeof(PointCloud::Point);
+  }
+  for (size_t i = 0; i < coarse_points_.size(); ++i)
+    point_bytes += coarse_points_[i].capacity() * sizeof(PointCloud::Point);
+  point_bytes += centerBytes(new_centers_.get());
+  if (shown_centers_ != new_centers_)
+    point_bytes += centerBytes(shown_centers_.get());
+  for (size_t i = 0; i < region_points_.size(); ++i)
+    point_bytes += region_points_[i].capacity() * sizeof(PointCloud::Point);
+  memory_.set(MemoryAccounting::POINT_BUFFERS, point_bytes);
+}
+
+static std::size_t countNodes(const ArenaOcTree& octree, unsigned int depth)
+{
+  std::size_t count = 0;
+  for (ArenaOcTree::iterator it = octree.begin(depth), end = octree.end(); it != end; ++it)
+    ++count;
+  return count;
+}
+
+// Morton codes [begin, end) of the leaves inside the node at key and depth
+static void mortonRange(const ArenaOcTree& octree, const octomap::OcTreeKey& key, unsigned int depth, uint64_t& begin,
+                        uint64_t& end)
+{
+  octomap::OcTreeKey index_key = octree.getIndexKey(key, depth);
+  begin = mortonEncode(index_key[0], index_key[1], index_key[2]);
+  end = begin + (static_cast<uint64_t>(1) << (3 * (octree.getTreeDepth() - depth)));
+}
+
+bool OccupancyGridDisplay::extractProgressively(VoxelSet set, unsigned int coarse_depth, unsigned int tree_depth,
+                                                std::size_t max_points, std::size_t& point_count)
+{
+  std::size_t coarse_count;
+  if (!extractor_.extract(octree_, set, coarse_depth, max_points, coarse_points_, coarse_count))
+    return false;
 
-  if (pointCount)
   {
+    TraceScope trace("handoff");
     boost::mutex::scoped_lock lock(mutex_);
+    refinement_steps_.push_back(RefinementStep());
+    refinement_steps_.back().set = set;
+    refinement_steps_.back().replace = true;
+    refinement_steps_.back().points = coarse_points_;
+  }
+
+  // regions are at most as deep as the preview, so a coarse voxel lies in one
+  // of them unless it is a merged or uniform voxel spanning several
+  unsigned int region_depth = 1;
+  while (region_depth < coarse_depth && countNodes(octree_, region_depth) < min_refinement_regions_)
+    ++region_depth;
+
+  for (size_t i = 0; i < max_octree_depth_; ++i)
+    point_buf_[set][i].clear();
+  point_buf_[set].resize(max_octree_depth_);
+
+  std::vector<std::size_t> cursor(max_octree_depth_, 0);
+  point_count = 0;
+
+  RefinementStep step;
+  step.set = set;
+  step.replace = false;
 
-    new_points_received_ = true;
+  for (ArenaOcTree::iterator it = octree_.begin(region_depth), end = octree_.end(); it != end; ++it)
+  {
+    std::size_t region_count;
+    if (!extractor_.extractRegion(octree_, set, it, tree_depth, max_points - point_count, region_points_,
+                                  region_count))
+    {
+      return false;
+    }
+    point_count += region_count;
+
+    step.pop.assign(max_octree_depth_, 0);
 
+    // the coarse voxels of this region come next in Morton order. A voxel
+    // spanning several regions stays until all of them are refined and is
+    // popped with the next region after it, or with the leftovers, so the
+    // preview never shows holes.
+    uint64_t region_begin, region_end;
+    mortonRange(octree_, it.getKey(), it.getDepth(), region_begin, region_end);
+    bool changed = region_count > 0;
     for (size_t i = 0; i < max_octree_depth_; ++i)
-      new_points_[i].swap(point_buf_[i]);
+    {
+      const VPoint& coarse = coarse_points_[i];
+      std::size_t first = cursor[i];
+      for (; cursor[i] < coarse.size(); ++cursor[i])
+      {
+        const Ogre::Vector3& position = coarse[cursor[i]].position;
+        uint64_t voxel_begin, voxel_end;
+        mortonRange(octree_, octree_.coordToKey(position.x, position.y, position.z), i + 1, voxel_begin, voxel_end);
+
+        bool inside = voxel_begin >= region_begin && voxel_end <= region_end;
+        if (!inside && voxel_end > region_begin)
+          break;
+      }
+      step.pop[i] = cursor[i] - first;
+      changed |= step.pop[i] > 0;
+
+      point_buf_[set][i].insert(point_buf_[set][i].end(), region_points_[i].begin(), region_points_[i].end());
+    }
+
+    if (!changed)
+      continue;
+
+    step.points.swap(region_points_);
+
+    TraceScope trace("handoff");
+    boost::mutex::scoped_lock lock(mutex_);
+    refinement_steps_.push_back(RefinementStep());
+    refinement_steps_.back().set = set;
+    refinement_steps_.back().replace = false;
+    refinement_steps_.back().pop.swap(step.pop);
+    refinement_steps_.back().points.swap(step.points);
+  }
+
+  // coarse voxels spanning the last regions
+  bool leftover = false;
+  step.pop.assign(max_octree_depth_, 0);
+  for (size_t i = 0; i < max_octree_depth_; ++i)
+  {
+    step.pop[i] = coarse_points_[i].size() - cursor[i];
+    leftover |= step.pop[i] > 0;
+  }
+
+  if (leftover)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    refinement_steps_.push_back(RefinementStep());
+    refinement_steps_.back().set = set;
+    refinement_steps_.back().replace = false;
+    refinement_steps_.back().pop.swap(step.pop);
+    refinement_steps_.back().points.resize(max_octree_depth_);
+  }
+
+  return true;
+}
 
+void OccupancyGridDisplay::reextractVoxelSets()
+{
+  std::string map_frame;
+  ros::Time map_stamp;
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    map_frame = map_frame_;
+    map_stamp = map_stamp_;
+  }
+
+  {
+    boost::mutex::scoped_lock tree_lock(octree_mutex_);
+
+    if (octree_.empty())
+      return;
+
+    updateFocus(map_frame, map_stamp);
+
+    // hidden sets are dropped so they do not hold memory under the old
+    // settings, they are built again when shown
+    int render_mode_mask = octree_render_property_->getOptionInt();
+    for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+      voxel_set_extracted_[set] = false;
+    for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+    {
+      if (voxelSetMask(set) & render_mode_mask)
+        extractVoxelSet(static_cast<VoxelSet>(set));
+      else
+        dropVoxelSet(static_cast<VoxelSet>(set));
+    }
+
+    updatePointBufferMemory();
+  }
+
+  updateMemoryStatus();
+}
+
+void OccupancyGridDisplay::updateFocus(const std::string& map_frame, const ros::Time& stamp)
+{
+  if (!max_voxels_property_->getInt())
+    return;
+
+  Ogre::Vector3 map_position, focus_position;
+  Ogre::Quaternion map_orientation, focus_orientation;
+  const std::string& focus_frame = focus_frame_property_->getFrameStd();
+  if (!getFrameTransform(map_frame, stamp, map_position, map_orientation)
+      || !getFrameTransform(focus_frame, stamp, focus_position, focus_orientation))
+  {
+    setStatusStd(StatusProperty::Warn, "Focus Frame",
+                 "Failed to transform from frame [" + focus_frame + "] to frame [" + map_frame
+                 + "], keeping the previous focus");
+    return;
   }
-  delete octomap;
+  deleteStatusStd("Focus Frame");
+
+  Ogre::Vector3 focus = map_orientation.Inverse() * (focus_position - map_position);
+  for (int i = 0; i < 3; ++i)
+    focus_[i] = focus[i];
+}
+
+void OccupancyGridDisplay::updateVoxelBudget()
+{
+  work_queue_.submit(boost::bind(&OccupancyGridDisplay::reextractVoxelSets, this));
+}
+
+void OccupancyGridDisplay::updateMergeTolerance()
+{
+  work_queue_.submit(boost::bind(&OccupancyGridDisplay::reextractVoxelSets, this));
 }
 
 void OccupancyGridDisplay::updateTreeDepth()
 {
+  work_queue_.submit(boost::bind(&OccupancyGridDisplay::reextractVoxelSets, this));
+}
+
+void OccupancyGridDisplay::extractMissingVoxelSets()
+{
+  {
+    boost::mutex::scoped_lock tree_lock(octree_mutex_);
+
+    if (octree_.empty())
+      return;
+
+    int render_mode_mask = octree_render_property_->getOptionInt();
+    for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+    {
+      if ((voxelSetMask(set) & render_mode_mask) && !voxel_set_extracted_[set])
+        extractVoxelSet(static_cast<VoxelSet>(set));
+    }
+
+    updatePointBufferMemory();
+  }
+
+  updateMemoryStatus();
 }
 
 void OccupancyGridDisplay::updateOctreeRenderMode()
 {
+  // sets which were not shown when the map arrived are built by the worker
+  work_queue_.submit(boost::bind(&OccupancyGridDisplay::extractMissingVoxelSets, this));
+
+  updateVoxelSetVisibility();
+  context_->queueRender();
+}
+
+void OccupancyGridDisplay::updateVoxelSetVisibility()
+{
+  int render_mode_mask = octree_render_property_->getOptionInt();
+  for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+  {
+    if (voxel_set_node_[set])
+      voxel_set_node_[set]->setVisible(voxelSetMask(set) & render_mode_mask);
+  }
 }
 
 void OccupancyGridDisplay::updateOctreeColorMode()
 {
+  work_queue_.submit(boost::bind(&OccupancyGridDisplay::reextractVoxelSets, this));
 }
 
-void OccupancyGridDisplay::clear()
+void OccupancyGridDisplay::updateMemoryLimit()
 {
+  work_queue_.submit(boost::bind(&OccupancyGridDisplay::reextractVoxelSets, this));
+}
 
-  boost::mutex::scoped_lock lock(mutex_);
+void OccupancyGridDisplay::updateSlice()
+{
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    slice_changed_ = true;
+  }
+  context_->queueRender();
+}
 
-  // reset rviz pointcloud boxes
-  for (size_t i = 0; i < cloud_.size(); ++i)
+void OccupancyGridDisplay::updateRenderStyle()
+{
   {
-    cloud_[i]->clear();
+    boost::mutex::scoped_lock lock(mutex_);
+    render_style_changed_ = true;
   }
+  context_->queueRender();
 }
 
-void OccupancyGridDisplay::update(float wall_dt, float ros_dt)
+void OccupancyGridDisplay::updateOcclusionCulling()
 {
-  if (new_points_received_)
+  // the occluders are built along with the voxels
+  if (occlusion_property_->getBool())
+  {
+    work_queue_.submit(boost::bind(&OccupancyGridDisplay::reextractVoxelSets, this));
+  }
+  else
   {
     boost::mutex::scoped_lock lock(mutex_);
+    shown_centers_.reset();
+  }
+  context_->queueRender();
+}
+
+void OccupancyGridDisplay::updateWorkerThreads()
+{
+  WorkerPool::instance().setThreadCount(worker_threads_property_->getInt());
+  updateQueueStatus();
+}
+
+void OccupancyGridDisplay::updateTransformTime()
+{
+  context_->queueRender();
+}
+
+bool OccupancyGridDisplay::getFrameTransform(const std::string& frame_id, const ros::Time& stamp,
+                                           Ogre::Vector3& position, Ogre::Quaternion& orientation)
+{
+  ros::Time time = transform_time_property_->getOptionInt() == OCTOMAP_LATEST_TRANSFORM ? ros::Time() : stamp;
+  return context_->getFrameManager()->getTransform(frame_id, time, position, orientation);
+}
+
+void OccupancyGridDisplay::updateMapTransform()
+{
+  if (map_frame_.empty())
+    return;
+
+  // served from the frame manager cache, so this is cheap to do every frame
+  Ogre::Vector3 position;
+  Ogre::Quaternion orientation;
+  bool transform_ok = getFrameTransform(map_frame_, map_stamp_, position, orientation);
+  if (transform_ok)
+  {
+    scene_node_->setPosition(position);
+    scene_node_->setOrientation(orientation);
+  }
+
+  // the status is only touched when the lookup starts or stops failing
+  if (transform_ok == transform_ok_)
+    return;
+
+  transform_ok_ = transform_ok;
+  if (transform_ok)
+  {
+    deleteStatusStd("Transform");
+  }
+  else
+  {
+    std::stringstream ss;
+    ss << "Failed to transform from frame [" << map_frame_ << "] to frame ["
+        << context_->getFrameManager()->getFixedFrame() << "], showing the last known pose";
+    setStatusStd(StatusProperty::Warn, "Transform", ss.str());
+  }
+}
+
+void OccupancyGridDisplay::updateRecordFile()
+{
+  boost::mutex::scoped_lock lock(record_mutex_);
+
+  recorder_.close();
+
+  const std::string& path = record_file_property_->getStdString();
+  if (path.empty())
+  {
+    deleteStatusStd("Recording");
+    return;
+  }
+
+  if (!recorder_.open(path))
+  {
+    setStatusStd(StatusProperty::Error, "Recording", "Failed to open " + path);
+    return;
+  }
+
+  record_start_ = ros::WallTime::now();
+  setStatusStd(StatusProperty::Ok, "Recording", "Recording to " + path);
+}
+
+void OccupancyGridDisplay::recordMessage(const octomap_msgs::Octomap& msg, const Ogre::Vector3& map_position,
+                                         const Ogre::Quaternion& map_orientation)
+{
+  boost::mutex::scoped_lock lock(record_mutex_);
+
+  if (!recorder_.isOpen())
+    return;
+
+  RecordedFrame frame;
+  frame.receive_time = (ros::WallTime::now() - record_start_).toSec();
+  for (int i = 0; i < 3; ++i)
+    frame.map_position[i] = map_position[i];
+  frame.map_orientation[0] = map_orientation.w;
+  frame.map_orientation[1] = map_orientation.x;
+  frame.map_orientation[2] = map_orientation.y;
+  frame.map_orientation[3] = map_orientation.z;
+
+  {
+    boost::mutex::scoped_lock camera_lock(mutex_);
+
+    for (int i = 0; i < 3; ++i)
+      frame.camera_position[i] = camera_position_[i];
+    frame.camera_orientation[0] = camera_orientation_.w;
+    frame.camera_orientation[1] = camera_orientation_.x;
+    frame.camera_orientation[2] = camera_orientation_.y;
+    frame.camera_orientation[3] = camera_orientation_.z;
+  }
+
+  frame.message = msg;
+
+  if (!recorder_.write(frame))
+  {
+    recorder_.close();
+    setStatusStd(StatusProperty::Error, "Recording", "Failed to write " + record_file_property_->getStdString());
+  }
+}
+
+void OccupancyGridDisplay::updateMemoryStatus()
+{
+  setStatusStd(StatusProperty::Ok, "Memory", memory_.summary());
+}
+
+void OccupancyGridDisplay::clear()
+{
+  {
+    boost::mutex::scoped_lock tree_lock(octree_mutex_);
+
+    octree_.clear();
+    for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+      voxel_set_extracted_[set] = false;
+  }
+
+  boost::mutex::scoped_lock lock(mutex_);
+
+  map_frame_.clear();
+  refinement_steps_.clear();
+  // results of a pass still running do not match any cloud generation
+  occlusion_pending_ = false;
+  occlusion_ready_ = false;
+  occlusion_hiding_ = false;
+  occlusion_state_.clear();
+  occlusion_centers_.reset();
+  shown_centers_.reset();
+  for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+  {
+    progressive_uploaded_[set] = false;
+    refining_[set] = false;
+  }
+
+  if (!transform_ok_)
+  {
+    transform_ok_ = true;
+    deleteStatusStd("Transform");
+  }
+
+  // release rviz pointcloud boxes
+  for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+  {
+    for (size_t i = 0; i < cloud_[set].size(); ++i)
+    {
+      destroyCloud(set, i);
+      shown_points_[set][i].clear();
+      shown_layers_[set][i].clear();
+      slice_points_[set][i].clear();
+      cloud_extent_[set][i].points = 0;
+    }
+  }
+
+  memory_.set(MemoryAccounting::RENDER_BUFFERS, 0);
+  updateBatchStatus();
+}
+
+void OccupancyGridDisplay::createCloud(int set, std::size_t i)
+{
+  std::stringstream sname;
+  sname << (set == VoxelExtractor::OCCUPIED_SET ? "Occupied" : "Free") << " PointCloud Nr." << i;
+  cloud_[set][i] = new ChunkedCloud(voxel_set_node_[set], sname.str());
+  cloud_[set][i]->setRenderMode(static_cast<rviz::PointCloud::RenderMode>(cloud_style_[set][i]));
+  applied_style_[set][i] = cloud_style_[set][i];
+}
+
+void OccupancyGridDisplay::destroyCloud(int set, std::size_t i)
+{
+  if (!cloud_[set][i])
+    return;
+
+  delete cloud_[set][i];
+  cloud_[set][i] = NULL;
+}
+
+void OccupancyGridDisplay::updateBatchStatus()
+{
+  std::size_t style_clouds[rviz::PointCloud::RM_BOXES + 1] = { 0 };
+  std::size_t active_clouds = 0;
+  std::size_t vertices = 0;
+  for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+  {
+    for (size_t i = 0; i < cloud_[set].size(); ++i)
+    {
+      if (!cloud_[set][i])
+        continue;
+
+      active_clouds += cloud_[set][i]->batchCount();
+      style_clouds[applied_style_[set][i]] += cloud_[set][i]->batchCount();
+      vertices += cloud_extent_[set][i].points * verticesPerPoint(applied_style_[set][i]);
+    }
+  }
+
+  std::stringstream ss;
+  ss << active_clouds << " active point clouds (" << style_clouds[rviz::PointCloud::RM_BOXES] << " boxes, "
+     << style_clouds[rviz::PointCloud::RM_FLAT_SQUARES] << " flat squares, "
+     << style_clouds[rviz::PointCloud::RM_POINTS] << " points), " << vertices << " vertices";
+  setStatusStd(StatusProperty::Ok, "Render Batches", ss.str());
+}
+
+void OccupancyGridDisplay::update(float wall_dt, float ros_dt)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+
+  // remember the view for message recordings, the camera must only be
+  // accessed from the render thread
+  rviz::ViewController* view = context_->getViewManager()->getCurrent();
+  if (view && view->getCamera())
+  {
+    camera_position_ = view->getCamera()->getDerivedPosition();
+    camera_orientation_ = view->getCamera()->getDerivedOrientation();
+
+    // maps of displays in view are decoded first
+    const Ogre::AxisAlignedBox& bounds = scene_node_->_getWorldAABB();
+    bool in_view = bounds.isNull() || view->getCamera()->isVisible(bounds);
+    work_queue_.setPriority(in_view ? WorkerPool::HIGH_PRIORITY : WorkerPool::LOW_PRIORITY);
+  }
+
+  updateMapTransform();
+
+  applyRefinementSteps();
+
+  bool upload[NUM_VOXEL_SETS];
+  bool uploaded = false;
+  for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+  {
+    bool reselect = new_points_received_[set] || slice_changed_;
+    upload[set] = reselect;
+
+    if (new_points_received_[set])
+    {
+      // progressively refined clouds already hold the new voxels
+      if (progressive_uploaded_[set] && !slice_changed_)
+        upload[set] = false;
+      progressive_uploaded_[set] = false;
+
+      // keep the new voxels around for slicing, the old ones become the next
+      // extraction buffer
+      for (size_t i = 0; i < max_octree_depth_; ++i)
+      {
+        shown_points_[set][i].swap(new_points_[set][i]);
+        shown_layers_[set][i].swap(new_layers_[set][i]);
+        new_points_[set][i].clear();
+      }
+      if (set == VoxelExtractor::OCCUPIED_SET)
+      {
+        shown_centers_ = new_centers_;
+        new_centers_.reset();
+      }
+      new_points_received_[set] = false;
+      refining_[set] = false;
+    }
+
+    if (reselect)
+    {
+      selectVoxels(set);
+      uploaded = true;
+    }
+  }
+  slice_changed_ = false;
+
+  // styles are chosen before uploading so new points are only built once
+  bool restyled = updateRenderStyles(view ? view->getCamera() : NULL);
+
+  std::size_t uploaded_voxels = 0;
+  std::size_t total_voxels = 0;
+  for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+  {
+    if (upload[set])
+    {
+      TraceScope trace("upload");
+
+      for (size_t i = 0; i < max_octree_depth_; ++i)
+      {
+        uploaded_voxels += uploadCloud(set, i);
+        total_voxels += cloud_extent_[set][i].points;
+      }
+    }
+    else if (restyled)
+    {
+      for (size_t i = 0; i < max_octree_depth_; ++i)
+        applyCloudStyle(set, i);
+    }
+  }
+
+  updateOcclusion(view ? view->getCamera() : NULL);
+
+  if (total_voxels)
+  {
+    std::stringstream ss;
+    ss << "Uploaded " << uploaded_voxels << " of " << total_voxels << " voxels in changed chunks";
+    setStatusStd(StatusProperty::Ok, "Upload", ss.str());
+  }
+
+  if (uploaded || restyled)
+  {
+    updateRenderMemory();
+    updateMemoryStatus();
+    updateBatchStatus();
+  }
+}
+
+Ogre::Vector3 OccupancyGridDisplay::getMapFrameEye(const Ogre::Camera* camera)
+{
+  return scene_node_->_getDerivedOrientation().Inverse()
+         * (camera->getDerivedPosition() - scene_node_->_getDerivedPosition());
+}
+
+void OccupancyGridDisplay::updateOcclusion(const Ogre::Camera* camera)
+{
+  if (!occlusion_property_->getBool())
+  {
+    if (occlusion_active_)
+    {
+      showAllChunks();
+      deleteStatusStd("Occlusion");
+      occlusion_active_ = false;
+      occlusion_state_.clear();
+    }
+    return;
+  }
+  occlusion_active_ = true;
+
+  // the depth buffer assumes a perspective projection
+  if (!camera || camera->getProjectionType() != Ogre::PT_PERSPECTIVE)
+  {
+    showAllChunks();
+    occlusion_state_.clear();
+    return;
+  }
+
+  OcclusionCuller::View view;
+  Ogre::Quaternion map_orientation = scene_node_->_getDerivedOrientation().Inverse();
+  Ogre::Vector3 eye = getMapFrameEye(camera);
+  Ogre::Vector3 right = map_orientation * camera->getDerivedRight();
+  Ogre::Vector3 up = map_orientation * camera->getDerivedUp();
+  Ogre::Vector3 forward = map_orientation * camera->getDerivedDirection();
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    view.eye[axis] = eye[axis];
+    view.right[axis] = right[axis];
+    view.up[axis] = up[axis];
+    view.forward[axis] = forward[axis];
+  }
+  view.tan_half_fov[1] = std::tan(0.5 * camera->getFOVy().valueRadians());
+  view.tan_half_fov[0] = view.tan_half_fov[1] * camera->getAspectRatio();
+  view.near_clip = camera->getNearClipDistance();
+  view.far_clip = camera->getFarClipDistance();
+
+  std::vector<std::size_t> state;
+  getOcclusionState(state);
+
+  // results stay valid whichever way the camera turns and while the eye
+  // stays near where the pass was queued, but not once the voxels changed
+  double tolerance = getOcclusionTolerance();
+  bool state_valid = state == occlusion_state_;
+  bool valid = state_valid && viewMatches(view, occlusion_view_, tolerance);
+
+  if (occlusion_ready_)
+  {
+    occlusion_ready_ = false;
+    occlusion_pending_ = false;
+
+    if (valid)
+    {
+      std::size_t hidden = 0;
+      for (size_t q = 0; q < occlusion_queries_.size(); ++q)
+      {
+        const OcclusionQuery& query = occlusion_queries_[q];
+        ChunkedCloud* cloud = cloud_[query.set][query.depth_index];
+        if (cloud)
+          hidden += cloud->setChunkVisibility(query.generation, query.visible);
+      }
+      occlusion_hiding_ = hidden > 0;
+      occlusion_applied_view_ = occlusion_view_;
+
+      std::size_t chunks = 0;
+      for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+      {
+        for (size_t i = 0; i < cloud_[set].size(); ++i)
+          chunks += cloud_[set][i] ? cloud_[set][i]->chunkCount() : 0;
+      }
+
+      std::stringstream ss;
+      ss << "Hiding " << hidden << " of " << chunks << " chunks";
+      setStatusStd(StatusProperty::Ok, "Occlusion", ss.str());
+    }
+  }
+
+  if (!state_valid || !viewMatches(view, occlusion_applied_view_, tolerance))
+    showAllChunks();
+
+  // turning the camera brings other occluders into view, so another pass is
+  // due once it turned by an eighth of the field of view; a moving eye gets
+  // a new pass halfway through the tolerance so that one is ready in time
+  double turned = 0.0;
+  for (int axis = 0; axis < 3; ++axis)
+    turned += view.forward[axis] * occlusion_view_.forward[axis];
+  double turn_limit = std::cos(0.125 * std::atan(std::max(view.tan_half_fov[0], view.tan_half_fov[1])));
+
+  if (occlusion_pending_
+      || (state_valid && viewMatches(view, occlusion_view_, 0.5 * tolerance) && turned >= turn_limit))
+    return;
+
+  occlusion_queries_.clear();
+  occlusion_occluders_.clear();
+  int render_mode_mask = octree_render_property_->getOptionInt();
+  for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+  {
+    for (size_t i = 0; i < cloud_[set].size(); ++i)
+    {
+      if (!cloud_[set][i] || !cloud_[set][i]->chunkCount())
+        continue;
+
+      occlusion_queries_.push_back(OcclusionQuery());
+      OcclusionQuery& query = occlusion_queries_.back();
+      query.set = set;
+      query.depth_index = i;
+      query.generation = cloud_[set][i]->generation();
+      cloud_[set][i]->getChunkBoxes(query.boxes);
+
+      // only occupied voxels drawn as solid boxes occlude, and only if the
+      // cloud holds exactly the shown points
+      if (set != VoxelExtractor::OCCUPIED_SET || !(voxelSetMask(set) & render_mode_mask) || refining_[set]
+          || applied_style_[set][i] != rviz::PointCloud::RM_BOXES)
+        continue;
+
+      occlusion_occluders_.push_back(OccluderLayer());
+      occlusion_occluders_.back().depth_index = i;
+      occlusion_occluders_.back().size = box_size_[i];
+    }
+  }
+
+  if (occlusion_queries_.empty())
+    return;
+
+  // the centers belong to the shown points, the pass selects the slice the
+  // way selectVoxels() does
+  occlusion_centers_ = shown_centers_;
+  occlusion_slice_ = slice_property_->getBool();
+  occlusion_slice_min_ = slice_height_property_->getFloat() - 0.5 * slice_thickness_property_->getFloat();
+  occlusion_slice_max_ = slice_height_property_->getFloat() + 0.5 * slice_thickness_property_->getFloat();
+  occlusion_tolerance_ = tolerance;
+  occlusion_view_ = view;
+  occlusion_state_.swap(state);
+  occlusion_pending_ = true;
+  work_queue_.submit(boost::bind(&OccupancyGridDisplay::cullOccludedChunks, this));
+}
+
+void OccupancyGridDisplay::getOcclusionState(std::vector<std::size_t>& state)
+{
+  state.clear();
+  for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+  {
+    state.push_back(refining_[set]);
+    for (size_t i = 0; i < cloud_[set].size(); ++i)
+    {
+      state.push_back(cloud_[set][i] ? cloud_[set][i]->generation() : 0);
+      state.push_back(applied_style_[set][i]);
+    }
+  }
+  state.push_back(octree_render_property_->getOptionInt());
+}
+
+double OccupancyGridDisplay::getOcclusionTolerance()
+{
+  // an eighth of the smallest chunk in use
+  double tolerance = std::numeric_limits<double>::infinity();
+  for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+  {
+    for (size_t i = 0; i < cloud_[set].size(); ++i)
+    {
+      if (cloud_[set][i] && cloud_[set][i]->chunkCount())
+        tolerance = std::min(tolerance, 0.125 * ChunkedCloud::CHUNK_VOXELS * box_size_[i]);
+    }
+  }
+  return tolerance;
+}
+
+void OccupancyGridDisplay::showAllChunks()
+{
+  if (!occlusion_hiding_)
+    return;
+
+  for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+  {
+    for (size_t i = 0; i < cloud_[set].size(); ++i)
+    {
+      if (cloud_[set][i])
+        cloud_[set][i]->showAllChunks();
+    }
+  }
+  occlusion_hiding_ = false;
+}
+
+void OccupancyGridDisplay::cullOccludedChunks()
+{
+  std::vector<OcclusionQuery> queries;
+  std::vector<OccluderLayer> occluders;
+  VVCenterConstPtr centers;
+  bool slice;
+  double slice_min, slice_max;
+  double tolerance;
+  OcclusionCuller::View view;
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    if (!occlusion_pending_)
+      return;
+
+    queries.swap(occlusion_queries_);
+    occluders.swap(occlusion_occluders_);
+    centers.swap(occlusion_centers_);
+    slice = occlusion_slice_;
+    slice_min = occlusion_slice_min_;
+    slice_max = occlusion_slice_max_;
+    tolerance = occlusion_tolerance_;
+    view = occlusion_view_;
+  }
+
+  {
+    TraceScope trace("occlusion");
+
+    OcclusionCuller culler;
+    culler.setView(view);
+    for (size_t l = 0; centers && l < occluders.size(); ++l)
+    {
+      const std::vector<Ogre::Vector3>& layer = (*centers)[occluders[l].depth_index];
+      double size = occluders[l].size;
+      double min_z = slice_min - 0.5 * size;
+      double max_z = slice_max + 0.5 * size;
+      for (size_t k = 0; k < layer.size(); ++k)
+      {
+        if (slice && !(layer[k].z >= min_z && layer[k].z <= max_z))
+          continue;
+
+        double center[3];
+        for (int axis = 0; axis < 3; ++axis)
+          center[axis] = layer[k][axis];
+        culler.addOccluder(center, size);
+      }
+    }
+    culler.finishOccluders();
+
+    // the results apply until the eye moved by the tolerance, which mostly
+    // uncovers the rim of a chunk, so the tested boxes are grown by as much
+
+    for (size_t q = 0; q < queries.size(); ++q)
+    {
+      OcclusionQuery& query = queries[q];
+      query.visible.resize(query.boxes.size());
+      for (size_t k = 0; k < query.boxes.size(); ++k)
+      {
+        double min[3], max[3];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          min[axis] = query.boxes[k].min[axis] - tolerance;
+          max[axis] = query.boxes[k].max[axis] + tolerance;
+        }
+        query.visible[k] = culler.isBoxVisible(min, max);
+      }
+    }
+  }
+
+  boost::mutex::scoped_lock lock(mutex_);
+  if (!occlusion_pending_)
+    return;
+
+  occlusion_queries_.swap(queries);
+  occlusion_ready_ = true;
+}
+
+OccupancyGridDisplay::VPoint& OccupancyGridDisplay::visiblePoints(int set, std::size_t i)
+{
+  return slice_property_->getBool() ? slice_points_[set][i] : shown_points_[set][i];
+}
+
+void OccupancyGridDisplay::selectVoxels(int set)
+{
+  bool slice = slice_property_->getBool();
+  double slice_min = slice_height_property_->getFloat() - 0.5 * slice_thickness_property_->getFloat();
+  double slice_max = slice_height_property_->getFloat() + 0.5 * slice_thickness_property_->getFloat();
+
+  for (size_t i = 0; i < max_octree_depth_; ++i)
+  {
+    double size = box_size_[i];
+
+    if (slice)
+    {
+      // voxels whose box intersects the slab
+      slice_points_[set][i].clear();
+      shown_layers_[set][i].select(shown_points_[set][i], slice_min - 0.5 * size, slice_max + 0.5 * size,
+                                   slice_points_[set][i]);
+    }
+
+    cloud_extent_[set][i].points = 0;
+    growCloudExtent(set, i, visiblePoints(set, i));
+  }
+}
+
+void OccupancyGridDisplay::growCloudExtent(int set, std::size_t i, const VPoint& points)
+{
+  CloudExtent& extent = cloud_extent_[set][i];
+  if (points.empty())
+    return;
+
+  if (!extent.points)
+    extent.min = extent.max = points.front().position;
+
+  for (size_t k = 0; k < points.size(); ++k)
+  {
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      extent.min[axis] = std::min(extent.min[axis], points[k].position[axis]);
+      extent.max[axis] = std::max(extent.max[axis], points[k].position[axis]);
+    }
+  }
+  extent.points += points.size();
+}
+
+void OccupancyGridDisplay::applyRefinementSteps()
+{
+  if (refinement_steps_.empty())
+    return;
+
+  TraceScope trace("upload");
+
+  for (; !refinement_steps_.empty(); refinement_steps_.pop_front())
+  {
+    RefinementStep& step = refinement_steps_.front();
+    int set = step.set;
+    refining_[set] = true;
 
     for (size_t i = 0; i < max_octree_depth_; ++i)
     {
-      double size = box_size_[i];
+      CloudExtent& extent = cloud_extent_[set][i];
+      if (step.replace)
+      {
+        if (cloud_[set][i])
+          cloud_[set][i]->clear();
+        extent.points = 0;
+      }
+      else if (step.pop[i] && cloud_[set][i])
+      {
+        // the extent keeps its bounds until the refinement is complete
+        cloud_[set][i]->popFront(step.pop[i]);
+        extent.points -= std::min(extent.points, step.pop[i]);
+      }
+
+      if (!step.points[i].empty())
+      {
+        if (!cloud_[set][i])
+          createCloud(set, i);
+
+        growCloudExtent(set, i, step.points[i]);
+        applyCloudStyle(set, i);
+        cloud_[set][i]->append(step.points[i], box_size_[i]);
+      }
+
+      if (!extent.points)
+        destroyCloud(set, i);
+    }
+  }
+
+  updateRenderMemory();
+  updateBatchStatus();
+}
+
+bool OccupancyGridDisplay::updateRenderStyles(const Ogre::Camera* camera)
+{
+  int style = render_style_property_->getOptionInt();
+  bool changed = render_style_changed_;
+  render_style_changed_ = false;
+
+  if (style != OCTOMAP_AUTO_STYLE)
+  {
+    for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+      std::fill(cloud_style_[set].begin(), cloud_style_[set].end(), style);
+    return changed;
+  }
+
+  // projected size in pixels of one meter at unit distance
+  double pixels_per_meter = std::numeric_limits<double>::infinity();
+  Ogre::Vector3 eye = Ogre::Vector3::ZERO;
+  if (camera && camera->getViewport())
+  {
+    pixels_per_meter = camera->getViewport()->getActualHeight() / (2.0 * std::tan(0.5 * camera->getFOVy().valueRadians()));
+
+    // the extents are kept in the map frame
+    eye = getMapFrameEye(camera);
+  }
+
+  double near_clip = camera ? camera->getNearClipDistance() : 0.0;
+  double remaining = vertex_budget_property_->getInt();
+  int render_mode_mask = octree_render_property_->getOptionInt();
+
+  // coarse depths hold few large voxels and are served first, finer depths
+  // fall back to cheaper styles once the budget runs out
+  for (size_t i = 0; i < max_octree_depth_; ++i)
+  {
+    double size = box_size_[i];
+
+    for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+    {
+      const CloudExtent& extent = cloud_extent_[set][i];
+      if (!extent.points || !(voxelSetMask(set) & render_mode_mask))
+        continue;
+
+      // distance to the closest voxel box of this depth
+      double distance_squared = 0.0;
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        double below = extent.min[axis] - 0.5 * size - eye[axis];
+        double above = eye[axis] - extent.max[axis] - 0.5 * size;
+        double outside = std::max(0.0, std::max(below, above));
+        distance_squared += outside * outside;
+      }
+      double distance = std::max(near_clip, std::sqrt(distance_squared));
+
+      double pixels = distance > 0.0 ? size * pixels_per_meter / distance : std::numeric_limits<double>::infinity();
+      int cloud_style = autoRenderStyle(pixels, cloud_style_[set][i]);
+
+      while (cloud_style != rviz::PointCloud::RM_POINTS
+             && extent.points * verticesPerPoint(cloud_style) > remaining)
+      {
+        cloud_style = cloud_style == rviz::PointCloud::RM_BOXES ? rviz::PointCloud::RM_FLAT_SQUARES
+                                                                : rviz::PointCloud::RM_POINTS;
+      }
+      remaining = std::max(0.0, remaining - extent.points * verticesPerPoint(cloud_style));
+
+      if (cloud_style != cloud_style_[set][i])
+      {
+        cloud_style_[set][i] = cloud_style;
+        changed = true;
+      }
+    }
+  }
+
+  return changed;
+}
+
+std::size_t OccupancyGridDisplay::uploadCloud(int set, std::size_t i)
+{
+  VPoint& points = visiblePoints(set, i);
+
+  // depths without voxels do not keep a point cloud around
+  if (points.empty())
+  {
+    destroyCloud(set, i);
+    return 0;
+  }
+
+  if (!cloud_[set][i])
+    createCloud(set, i);
+
+  applyCloudStyle(set, i);
+
+  // slices are selected layer by layer and not in Morton order
+  if (slice_property_->getBool())
+  {
+    cloud_[set][i]->clear();
+    cloud_[set][i]->append(points, box_size_[i]);
+    return points.size();
+  }
+
+  return cloud_[set][i]->update(points, box_size_[i]);
+}
+
+void OccupancyGridDisplay::applyCloudStyle(int set, std::size_t i)
+{
+  if (!cloud_[set][i])
+    return;
 
-      cloud_[i]->clear();
-      cloud_[i]->setDimensions(size, size, size);
+  int style = cloud_style_[set][i];
+  if (style != applied_style_[set][i])
+  {
+    // rebuilds the renderables of points already added
+    cloud_[set][i]->setRenderMode(static_cast<rviz::PointCloud::RenderMode>(style));
+    applied_style_[set][i] = style;
+  }
 
-      cloud_[i]->addPoints(&new_points_[i].front(), new_points_[i].size());
-      new_points_[i].clear();
+  // points are sized in pixels, the other styles in meters
+  double size = style == rviz::PointCloud::RM_POINTS ? 1.0 : box_size_[i];
+  cloud_[set][i]->setDimensions(size, size, size);
+}
 
+void OccupancyGridDisplay::updateRenderMemory()
+{
+  std::size_t render_bytes = 0;
+  for (int set = 0; set < NUM_VOXEL_SETS; ++set)
+  {
+    for (size_t i = 0; i < cloud_[set].size(); ++i)
+    {
+      if (cloud_[set][i])
+      {
+        render_bytes += cloud_extent_[set][i].points
+                        * (verticesPerPoint(applied_style_[set][i]) * bytes_per_vertex_ + sizeof(PointCloud::Point));
+      }
     }
-    new_points_received_ = false;
   }
+  memory_.set(MemoryAccounting::RENDER_BUFFERS, render_bytes);
 }
 
 void OccupancyGridDisplay::reset()
 {
   clear();
   messages_received_ = 0;
+  memory_.reset();
   setStatus(StatusProperty::Ok, "Messages", QString("0 binary octomap messages received"));
 }
 
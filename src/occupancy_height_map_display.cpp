@@ -0,0 +1,509 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <QObject>
+
+#include "octomap_rviz_plugins/occupancy_height_map_display.h"
+
+#include <boost/bind.hpp>
+
+#include <OGRE/OgreManualObject.h>
+#include <OGRE/OgreSceneManager.h>
+#include <OGRE/OgreSceneNode.h>
+
+#include "rviz/frame_manager.h"
+#include "rviz/visualization_manager.h"
+#include "rviz/properties/float_property.h"
+#include "rviz/properties/int_property.h"
+#include "rviz/properties/ros_topic_property.h"
+
+#include "octomap_rviz_plugins/tracing.h"
+#include "octomap_rviz_plugins/voxel_extractor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+using namespace rviz;
+
+namespace octomap_rviz_plugin
+{
+
+static const std::size_t max_octree_depth_ = sizeof(unsigned short) * 8;
+
+// length of the subscriber queue and of the messages waiting for the pool
+static const std::size_t queue_size_ = 5;
+
+// estimated size of a mesh vertex in the Ogre vertex buffer (position and
+// color)
+static const std::size_t bytes_per_vertex_ = 3 * sizeof(float) + sizeof(uint32_t);
+
+static const uint32_t no_vertex_ = std::numeric_limits<uint32_t>::max();
+
+// cells without occupied voxels are NaN
+static bool hasHeight(float z)
+{
+  return z == z;
+}
+
+OccupancyHeightMapDisplay::OccupancyHeightMapDisplay() :
+    rviz::Display(),
+    new_mesh_received_(false),
+    transform_ok_(true),
+    manual_object_(NULL),
+    messages_received_(0)
+{
+  octomap_topic_property_ = new RosTopicProperty( "Octomap Topic",
+                                                  "",
+                                                  QString::fromStdString(ros::message_traits::datatype<octomap_msgs::Octomap>()),
+                                                  "octomap_msgs::Octomap topic to subscribe to (binary or full probability map)",
+                                                  this,
+                                                  SLOT( updateTopic() ));
+
+  tree_depth_property_ = new IntProperty("Max. Octree Depth",
+                                         max_octree_depth_,
+                                         "Defines the maximum tree depth, which sets the size of the mesh cells.",
+                                         this,
+                                         SLOT (updateTreeDepth() ));
+  tree_depth_property_->setMin(0);
+
+  color_factor_property_ = new FloatProperty("Color Factor",
+                                             0.8,
+                                             "Hue range the height range of the map is colored with.",
+                                             this,
+                                             SLOT (updateColorFactor() ));
+  color_factor_property_->setMin(0.0);
+}
+
+void OccupancyHeightMapDisplay::onInitialize()
+{
+  static int count = 0;
+  std::stringstream ss;
+  ss << "OctomapHeightMap" << count++;
+
+  boost::mutex::scoped_lock lock(mutex_);
+
+  manual_object_ = scene_manager_->createManualObject(ss.str());
+  manual_object_->setDynamic(true);
+  scene_node_->attachObject(manual_object_);
+}
+
+OccupancyHeightMapDisplay::~OccupancyHeightMapDisplay()
+{
+  unsubscribe();
+
+  if (manual_object_)
+  {
+    scene_node_->detachObject(manual_object_);
+    scene_manager_->destroyManualObject(manual_object_);
+  }
+}
+
+void OccupancyHeightMapDisplay::onEnable()
+{
+  scene_node_->setVisible(true);
+  subscribe();
+}
+
+void OccupancyHeightMapDisplay::onDisable()
+{
+  scene_node_->setVisible(false);
+  unsubscribe();
+
+  clear();
+}
+
+void OccupancyHeightMapDisplay::subscribe()
+{
+  if (!isEnabled())
+  {
+    return;
+  }
+
+  try
+  {
+    unsubscribe();
+
+    const std::string& topicStr = octomap_topic_property_->getStdString();
+
+    if (!topicStr.empty())
+    {
+
+      sub_.reset(new message_filters::Subscriber<octomap_msgs::Octomap>());
+
+      sub_->subscribe(threaded_nh_, topicStr, queue_size_);
+      sub_->registerCallback(boost::bind(&OccupancyHeightMapDisplay::incomingMessageCallback, this, _1));
+
+    }
+  }
+  catch (ros::Exception& e)
+  {
+    setStatus(StatusProperty::Error, "Topic", (std::string("Error subscribing: ") + e.what()).c_str());
+  }
+
+}
+
+void OccupancyHeightMapDisplay::unsubscribe()
+{
+  try
+  {
+    // reset filters first, the subscriber waits for a running callback, so
+    // no message queues a new task while the state below is cleared
+    sub_.reset();
+  }
+  catch (ros::Exception& e)
+  {
+    setStatus(StatusProperty::Error, "Topic", (std::string("Error unsubscribing: ") + e.what()).c_str());
+  }
+
+  work_queue_.cancel();
+  {
+    boost::mutex::scoped_lock lock(pending_mutex_);
+    pending_messages_.clear();
+  }
+  // no task is queued or running after cancel()
+  octree_.clear();
+  heights_.heights.clear();
+  updateQueueStatus();
+
+  clear();
+}
+
+void OccupancyHeightMapDisplay::incomingMessageCallback(const octomap_msgs::OctomapConstPtr& msg)
+{
+  TraceScope trace("receive");
+
+  {
+    // like the subscriber queue, drop the oldest messages if projecting falls behind
+    boost::mutex::scoped_lock lock(pending_mutex_);
+    pending_messages_.push_back(msg);
+    while (pending_messages_.size() > queue_size_)
+      pending_messages_.pop_front();
+  }
+
+  work_queue_.submit(boost::bind(&OccupancyHeightMapDisplay::processPendingMessage, this));
+  updateQueueStatus();
+}
+
+void OccupancyHeightMapDisplay::processPendingMessage()
+{
+  octomap_msgs::OctomapConstPtr msg;
+  {
+    boost::mutex::scoped_lock lock(pending_mutex_);
+
+    // the message of this task may have been dropped
+    if (pending_messages_.empty())
+      return;
+
+    msg = pending_messages_.front();
+    pending_messages_.pop_front();
+  }
+
+  processMessage(msg);
+  updateQueueStatus();
+}
+
+void OccupancyHeightMapDisplay::updateQueueStatus()
+{
+  std::size_t pending;
+  {
+    boost::mutex::scoped_lock lock(pending_mutex_);
+    pending = pending_messages_.size();
+  }
+
+  std::stringstream ss;
+  ss << pending << " messages pending, " << WorkerPool::instance().threadCount() << " shared worker threads";
+  setStatusStd(StatusProperty::Ok, "Queue", ss.str());
+}
+
+void OccupancyHeightMapDisplay::processMessage(const octomap_msgs::OctomapConstPtr& msg)
+{
+  TraceScope trace("process");
+
+  ++messages_received_;
+  setStatus(StatusProperty::Ok, "Messages", QString::number(messages_received_) + " octomap messages received");
+
+  // decoding octree into the reused node arena, it is kept to project it
+  // again when the depth changes
+  bool decoded;
+  {
+    TraceScope trace("decode");
+    decoded = octree_.readMessage(*msg);
+  }
+
+  if (!decoded)
+  {
+    this->setStatusStd(StatusProperty::Error, "Message", "Failed to create octree structure");
+    return;
+  }
+  deleteStatusStd("Message");
+
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    map_frame_ = msg->header.frame_id;
+    map_stamp_ = msg->header.stamp;
+  }
+
+  memory_.set(MemoryAccounting::OCTREE, octree_.memoryUsage());
+  memory_.set(MemoryAccounting::MESSAGE_QUEUE, msg->data.size() * queue_size_);
+
+  projectHeights();
+}
+
+void OccupancyHeightMapDisplay::reprojectHeights()
+{
+  if (octree_.empty())
+    return;
+
+  TraceScope trace("reproject");
+  projectHeights();
+}
+
+void OccupancyHeightMapDisplay::projectHeights()
+{
+  unsigned int octree_depth = std::min<unsigned int>(tree_depth_property_->getInt(), octree_.getTreeDepth());
+
+  {
+    TraceScope trace("project");
+    MapProjector::projectHeights(octree_, octree_depth, heights_);
+  }
+
+  memory_.set(MemoryAccounting::OCCUPANCY_GRID, heights_.heights.size() * sizeof(float));
+
+  buildMesh();
+}
+
+void OccupancyHeightMapDisplay::buildMesh()
+{
+  const std::vector<float>& heights = heights_.heights;
+  if (heights.empty())
+    return;
+
+  TraceScope trace("mesh");
+
+  unsigned int width = heights_.info.width;
+  unsigned int height = heights_.info.height;
+  double res = heights_.info.resolution;
+
+  float min_z = std::numeric_limits<float>::max();
+  float max_z = -std::numeric_limits<float>::max();
+  for (std::size_t i = 0; i < heights.size(); ++i)
+  {
+    if (hasHeight(heights[i]))
+    {
+      min_z = std::min(min_z, heights[i]);
+      max_z = std::max(max_z, heights[i]);
+    }
+  }
+
+  // one vertex in the center of every cell with a height
+  Mesh mesh;
+  std::vector<uint32_t> vertex(heights.size(), no_vertex_);
+  double color_factor = color_factor_property_->getFloat();
+  rviz::PointCloud::Point point;
+  for (unsigned int y = 0; y < height; ++y)
+  {
+    for (unsigned int x = 0; x < width; ++x)
+    {
+      float z = heights[y * width + x];
+      if (!hasHeight(z))
+        continue;
+
+      vertex[y * width + x] = mesh.positions.size();
+      mesh.positions.push_back(Ogre::Vector3(heights_.info.origin.position.x + (x + 0.5) * res,
+                                             heights_.info.origin.position.y + (y + 0.5) * res,
+                                             z));
+      VoxelExtractor::setColor(z, min_z, max_z, color_factor, point);
+      mesh.colors.push_back(point.color);
+    }
+  }
+
+  // two counter-clockwise triangles per square of four vertices, one where
+  // a corner has no height
+  for (unsigned int y = 0; y + 1 < height; ++y)
+  {
+    for (unsigned int x = 0; x + 1 < width; ++x)
+    {
+      uint32_t corners[4] = { vertex[y * width + x], vertex[y * width + x + 1],
+                              vertex[(y + 1) * width + x + 1], vertex[(y + 1) * width + x] };
+
+      int missing = -1, count = 0;
+      for (int c = 0; c < 4; ++c)
+      {
+        if (corners[c] == no_vertex_)
+          missing = c;
+        else
+          ++count;
+      }
+
+      if (count == 4)
+      {
+        uint32_t triangles[6] = { corners[0], corners[1], corners[2], corners[0], corners[2], corners[3] };
+        mesh.indices.insert(mesh.indices.end(), triangles, triangles + 6);
+      }
+      else if (count == 3)
+      {
+        for (int c = 0; c < 4; ++c)
+        {
+          if (c != missing)
+            mesh.indices.push_back(corners[c]);
+        }
+      }
+    }
+  }
+
+  std::stringstream ss;
+  ss << mesh.positions.size() << " vertices, " << mesh.indices.size() / 3 << " triangles for " << width << " x "
+     << height << " cells";
+  setStatusStd(StatusProperty::Ok, "Mesh", ss.str());
+
+  memory_.set(MemoryAccounting::RENDER_BUFFERS,
+              mesh.positions.size() * bytes_per_vertex_ + mesh.indices.size() * sizeof(uint32_t));
+  setStatusStd(StatusProperty::Ok, "Memory", memory_.summary());
+
+  TraceScope handoff_trace("handoff");
+  boost::mutex::scoped_lock lock(mutex_);
+  new_mesh_.positions.swap(mesh.positions);
+  new_mesh_.colors.swap(mesh.colors);
+  new_mesh_.indices.swap(mesh.indices);
+  new_mesh_received_ = true;
+}
+
+void OccupancyHeightMapDisplay::updateMapTransform()
+{
+  if (map_frame_.empty())
+    return;
+
+  Ogre::Vector3 position;
+  Ogre::Quaternion orientation;
+  bool transform_ok = context_->getFrameManager()->getTransform(map_frame_, map_stamp_, position, orientation);
+  if (transform_ok)
+  {
+    scene_node_->setPosition(position);
+    scene_node_->setOrientation(orientation);
+  }
+
+  // the status is only touched when the lookup starts or stops failing
+  if (transform_ok == transform_ok_)
+    return;
+
+  transform_ok_ = transform_ok;
+  if (transform_ok)
+  {
+    deleteStatusStd("Transform");
+  }
+  else
+  {
+    std::stringstream ss;
+    ss << "Failed to transform from frame [" << map_frame_ << "] to frame ["
+        << context_->getFrameManager()->getFixedFrame() << "], showing the last known pose";
+    setStatusStd(StatusProperty::Warn, "Transform", ss.str());
+  }
+}
+
+void OccupancyHeightMapDisplay::update(float wall_dt, float ros_dt)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+
+  updateMapTransform();
+
+  if (!new_mesh_received_ || !manual_object_)
+    return;
+
+  TraceScope trace("upload");
+
+  manual_object_->clear();
+  if (!new_mesh_.indices.empty())
+  {
+    manual_object_->estimateVertexCount(new_mesh_.positions.size());
+    manual_object_->estimateIndexCount(new_mesh_.indices.size());
+    manual_object_->begin("BaseWhiteNoLighting", Ogre::RenderOperation::OT_TRIANGLE_LIST);
+    for (std::size_t i = 0; i < new_mesh_.positions.size(); ++i)
+    {
+      manual_object_->position(new_mesh_.positions[i]);
+      manual_object_->colour(new_mesh_.colors[i]);
+    }
+    for (std::size_t i = 0; i < new_mesh_.indices.size(); ++i)
+      manual_object_->index(new_mesh_.indices[i]);
+    manual_object_->end();
+  }
+
+  // the Ogre buffers hold the mesh now
+  new_mesh_ = Mesh();
+  new_mesh_received_ = false;
+}
+
+void OccupancyHeightMapDisplay::updateTreeDepth()
+{
+  work_queue_.submit(boost::bind(&OccupancyHeightMapDisplay::reprojectHeights, this));
+}
+
+void OccupancyHeightMapDisplay::updateColorFactor()
+{
+  work_queue_.submit(boost::bind(&OccupancyHeightMapDisplay::buildMesh, this));
+}
+
+void OccupancyHeightMapDisplay::clear()
+{
+  boost::mutex::scoped_lock lock(mutex_);
+
+  map_frame_.clear();
+  new_mesh_received_ = false;
+  if (manual_object_)
+    manual_object_->clear();
+
+  if (!transform_ok_)
+  {
+    transform_ok_ = true;
+    deleteStatusStd("Transform");
+  }
+}
+
+void OccupancyHeightMapDisplay::reset()
+{
+  clear();
+  messages_received_ = 0;
+  memory_.reset();
+  setStatus(StatusProperty::Ok, "Messages", QString("0 octomap messages received"));
+}
+
+void OccupancyHeightMapDisplay::updateTopic()
+{
+  unsubscribe();
+  reset();
+  subscribe();
+  context_->queueRender();
+}
+
+} // namespace octomap_rviz_plugin
+
+#include <pluginlib/class_list_macros.h>
+
+PLUGINLIB_EXPORT_CLASS( octomap_rviz_plugin::OccupancyHeightMapDisplay, rviz::Display)
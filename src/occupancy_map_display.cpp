@@ -33,13 +33,33 @@
 
 #include "octomap_rviz_plugins/occupancy_map_display.h"
 
+#include <boost/bind.hpp>
+
+#include <OGRE/OgreAxisAlignedBox.h>
+#include <OGRE/OgreCamera.h>
+#include <OGRE/OgreSceneNode.h>
+
+#include "rviz/frame_manager.h"
 #include "rviz/visualization_manager.h"
+#include "rviz/view_controller.h"
+#include "rviz/view_manager.h"
+#include "rviz/properties/bool_property.h"
+#include "rviz/properties/enum_property.h"
+#include "rviz/properties/float_property.h"
 #include "rviz/properties/int_property.h"
 #include "rviz/properties/ros_topic_property.h"
+#include "rviz/properties/string_property.h"
+#include "rviz/properties/tf_frame_property.h"
 
-#include <octomap/octomap.h>
 #include <octomap_msgs/Octomap.h>
-#include <octomap_msgs/conversions.h>
+
+#include "octomap_rviz_plugins/allocation_counter.h"
+#include "octomap_rviz_plugins/tracing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
 
 using namespace rviz;
 
@@ -48,9 +68,29 @@ namespace octomap_rviz_plugin
 
 static const std::size_t max_octree_depth_ = sizeof(unsigned short) * 8;
 
+// length of the subscriber queue and of the messages waiting for the pool
+static const std::size_t queue_size_ = 5;
+
+// opacity of the clearance overlay next to an obstacle
+static const float clearance_alpha_ = 0.7f;
+
+enum OctreeProjection
+{
+  OCTOMAP_LEAF_PROJECTION,
+  OCTOMAP_SUMMARY_PROJECTION,
+  OCTOMAP_PROBABILITY_PROJECTION
+};
+
 OccupancyMapDisplay::OccupancyMapDisplay()
   : rviz::MapDisplay()
   , octree_depth_ (max_octree_depth_)
+  , window_center_valid_ (false)
+  , window_cell_size_ (0.0)
+  , window_transform_ok_ (true)
+  , clearance_cell_size_ (0.0f)
+  , clearance_received_ (false)
+  , clearance_node_ (NULL)
+  , clearance_cloud_ (NULL)
 {
 
   topic_property_->setName("Octomap Binary Topic");
@@ -62,21 +102,313 @@ OccupancyMapDisplay::OccupancyMapDisplay()
                                          "Defines the maximum tree depth",
                                          this,
                                          SLOT (updateTreeDepth() ));
+  tree_depth_property_->setMin(1);
+  tree_depth_property_->setMax(max_octree_depth_);
+
+  memory_limit_property_ = new IntProperty("Memory Limit (MB)",
+                                           0,
+                                           "Upper bound for the memory used by this display. If a map would exceed it, "
+                                           "the octree depth is reduced until it fits. 0 disables the limit.",
+                                           this,
+                                           SLOT (updateMemoryLimit() ));
+  memory_limit_property_->setMin(0);
+
+  worker_threads_property_ = new IntProperty("Worker Threads",
+                                             0,
+                                             "Advanced: number of threads decoding maps for all octomap displays. "
+                                             "The pool is shared, the last value set applies. 0 uses one thread "
+                                             "less than the number of cores.",
+                                             this,
+                                             SLOT (updateWorkerThreads() ));
+  worker_threads_property_->setMin(0);
+
+  projection_property_ = new rviz::EnumProperty( "Projection", "Leafs",
+                                                 "Leafs visits every leaf. Summaries fills uniform subtrees in one step "
+                                                 "and skips subtrees which cannot change the grid anymore, Summaries "
+                                                 "(Probability) also writes the highest occupancy in percent instead "
+                                                 "of 100 and 0.",
+                                                 this,
+                                                 SLOT (updateProjection() ));
+  projection_property_->addOption( "Leafs", OCTOMAP_LEAF_PROJECTION );
+  projection_property_->addOption( "Summaries", OCTOMAP_SUMMARY_PROJECTION );
+  projection_property_->addOption( "Summaries (Probability)", OCTOMAP_PROBABILITY_PROJECTION );
+
+  z_bands_property_ = new StringProperty("Z Bands",
+                                         "",
+                                         "Height ranges in the map frame as min:max, separated by commas, e.g. "
+                                         "\"-0.1:0.1, 0.1:1.2, 1.2:2.5\". Every band is projected into a grid of its "
+                                         "own in the same traversal and shown bands are overlaid. Empty projects "
+                                         "the full height.",
+                                         this,
+                                         SLOT (updateZBands() ));
+
+  window_property_ = new BoolProperty("Rolling Window",
+                                      false,
+                                      "Project only a square window around a frame instead of the whole map. The "
+                                      "window follows the frame and only the newly exposed strips are projected.",
+                                      this,
+                                      SLOT (updateProjection() ));
+
+  window_frame_property_ = new TfFrameProperty("Frame",
+                                               "base_link",
+                                               "Frame the window is centered on.",
+                                               window_property_,
+                                               NULL,
+                                               false,
+                                               SLOT (updateProjection() ),
+                                               this);
+
+  window_size_property_ = new FloatProperty("Size (m)",
+                                            20.0,
+                                            "Edge length of the window, rounded to whole cells.",
+                                            window_property_,
+                                            SLOT (updateProjection() ),
+                                            this);
+  window_size_property_->setMin(0.0);
+
+  clearance_property_ = new BoolProperty("Clearance",
+                                         false,
+                                         "Overlay free cells with their distance to the nearest occupied cell, "
+                                         "from opaque red next to an obstacle fading out to yellow at the maximum "
+                                         "distance. The values of the map are left unchanged.",
+                                         this,
+                                         SLOT (updateProjection() ));
+
+  max_distance_property_ = new FloatProperty("Max. Distance (m)",
+                                             1.0,
+                                             "Distance beyond which free cells are not overlaid. Changed cells of "
+                                             "a new map only update the distances up to this far around them.",
+                                             clearance_property_,
+                                             SLOT (updateProjection() ),
+                                             this);
+  max_distance_property_->setMin(0.0);
 }
 
 OccupancyMapDisplay::~OccupancyMapDisplay()
 {
   unsubscribe();
+
+  if (clearance_node_)
+  {
+    clearance_node_->detachAllObjects();
+    scene_manager_->destroySceneNode(clearance_node_);
+  }
+  delete clearance_cloud_;
 }
 
 void OccupancyMapDisplay::onInitialize()
 {
   rviz::MapDisplay::onInitialize();
+
+  window_frame_property_->setFrameManager(context_->getFrameManager());
+
+  // the map display keeps its scene node at the origin of the shown map but
+  // scales it to the map extent for its unit quad, the overlay follows the
+  // pose only and is placed in meters
+  clearance_node_ = scene_node_->createChildSceneNode();
+  clearance_node_->setInheritScale(false);
+
+  clearance_cloud_ = new rviz::PointCloud();
+  clearance_cloud_->setName("Clearance");
+  clearance_cloud_->setRenderMode(rviz::PointCloud::RM_BOXES);
+  clearance_cloud_->setAlpha(1.0f, true);
+  clearance_node_->attachObject(clearance_cloud_);
 }
 
 void OccupancyMapDisplay::updateTreeDepth()
 {
   octree_depth_ = tree_depth_property_->getInt();
+  updateProjection();
+}
+
+void OccupancyMapDisplay::updateMemoryLimit()
+{
+  updateProjection();
+}
+
+void OccupancyMapDisplay::updateProjection()
+{
+  // the last map is projected again, no need to wait for the publisher
+  work_queue_.submit(boost::bind(&OccupancyMapDisplay::reprojectMap, this));
+}
+
+void OccupancyMapDisplay::updateWorkerThreads()
+{
+  WorkerPool::instance().setThreadCount(worker_threads_property_->getInt());
+  updateQueueStatus();
+}
+
+void OccupancyMapDisplay::updateZBands()
+{
+  std::vector<MapProjector::ZBand> bands;
+  bool valid = true;
+
+  std::string text = z_bands_property_->getStdString();
+  std::replace(text.begin(), text.end(), ',', ' ');
+  std::stringstream ss(text);
+  std::string token;
+  while (ss >> token)
+  {
+    MapProjector::ZBand band;
+    char separator = 0;
+    std::stringstream band_ss(token);
+    if (!(band_ss >> band.min_z >> separator >> band.max_z) || separator != ':' || !band_ss.eof()
+        || band.min_z >= band.max_z || bands.size() == MapProjector::MAX_Z_BANDS)
+    {
+      valid = false;
+      continue;
+    }
+    bands.push_back(band);
+  }
+
+  if (valid)
+    deleteStatusStd("Z Bands");
+  else
+    setStatusStd(StatusProperty::Warn, "Z Bands", "Ignored entries which are not min:max with min < max or "
+                 "exceed the maximum number of bands");
+
+  z_bands_property_->removeChildren();
+  band_properties_.clear();
+  for (std::size_t b = 0; b < bands.size(); ++b)
+  {
+    std::stringstream name, description;
+    name << "Band " << b + 1;
+    description << "Show heights from " << bands[b].min_z << " to " << bands[b].max_z << " m.";
+    band_properties_.push_back(new BoolProperty(QString::fromStdString(name.str()),
+                                                true,
+                                                QString::fromStdString(description.str()),
+                                                z_bands_property_,
+                                                SLOT (updateBandVisibility() ),
+                                                this));
+  }
+
+  {
+    boost::mutex::scoped_lock lock(band_mutex_);
+    z_bands_ = bands;
+    shown_bands_.assign(bands.size(), true);
+  }
+
+  updateProjection();
+}
+
+void OccupancyMapDisplay::updateBandVisibility()
+{
+  {
+    boost::mutex::scoped_lock lock(band_mutex_);
+    for (std::size_t b = 0; b < band_properties_.size() && b < shown_bands_.size(); ++b)
+      shown_bands_[b] = band_properties_[b]->getBool();
+  }
+
+  // the grids of the last map are blended again, no need to wait for a map
+  work_queue_.submit(boost::bind(&OccupancyMapDisplay::showBands, this));
+}
+
+void OccupancyMapDisplay::showBands()
+{
+  if (band_grids_.empty())
+    return;
+
+  std::vector<bool> shown;
+  {
+    boost::mutex::scoped_lock lock(band_mutex_);
+    shown = shown_bands_;
+  }
+
+  nav_msgs::OccupancyGrid::Ptr occupancy_map (new nav_msgs::OccupancyGrid());
+  occupancy_map->header = map_header_;
+  blendBands(shown, *occupancy_map);
+  updateClearance(*occupancy_map);
+
+  TraceScope handoff_trace("handoff");
+  this->incomingMap(occupancy_map);
+}
+
+std::size_t OccupancyMapDisplay::updateClearance(const nav_msgs::OccupancyGrid& grid)
+{
+  std::vector<rviz::PointCloud::Point> points;
+
+  if (!clearance_property_->getBool())
+  {
+    distance_transform_.clear();
+    deleteStatusStd("Clearance");
+  }
+  else
+  {
+    TraceScope trace("clearance");
+
+    double max_distance = max_distance_property_->getFloat();
+    std::size_t recomputed = distance_transform_.update(grid, max_distance);
+    const std::vector<float>& distances = distance_transform_.distances();
+
+    // one box per free cell within the maximum distance, relative to the map
+    // origin; occupied and unknown cells are not overlaid
+    unsigned int width = grid.info.width;
+    float resolution = grid.info.resolution;
+    for (std::size_t i = 0; i < distances.size() && i < grid.data.size(); ++i)
+    {
+      if (grid.data[i] < 0 || grid.data[i] >= DistanceTransform::OCCUPIED_VALUE || distances[i] >= max_distance)
+        continue;
+
+      float closeness = 1.0f - distances[i] / max_distance;
+      rviz::PointCloud::Point point;
+      point.position.x = (i % width + 0.5f) * resolution;
+      point.position.y = (i / width + 0.5f) * resolution;
+      point.position.z = 0.0f;
+      point.setColor(1.0f, 1.0f - closeness, 0.0f, clearance_alpha_ * closeness);
+      points.push_back(point);
+    }
+
+    std::stringstream ss;
+    ss << "Recomputed " << recomputed << " of " << grid.data.size() << " distances, " << points.size()
+       << " cells overlaid";
+    setStatusStd(StatusProperty::Ok, "Clearance", ss.str());
+  }
+
+  std::size_t count = points.size();
+  {
+    boost::mutex::scoped_lock lock(clearance_mutex_);
+    clearance_points_.swap(points);
+    clearance_cell_size_ = grid.info.resolution;
+    clearance_received_ = true;
+  }
+  return count;
+}
+
+void OccupancyMapDisplay::showClearance()
+{
+  std::vector<rviz::PointCloud::Point> points;
+  float cell_size;
+  {
+    boost::mutex::scoped_lock lock(clearance_mutex_);
+    if (!clearance_received_)
+      return;
+    points.swap(clearance_points_);
+    cell_size = clearance_cell_size_;
+    clearance_received_ = false;
+  }
+
+  // a thin slab just above the map
+  clearance_cloud_->clear();
+  clearance_cloud_->setDimensions(cell_size, cell_size, 0.01f * cell_size);
+  if (!points.empty())
+    clearance_cloud_->addPoints(&points.front(), points.size());
+}
+
+void OccupancyMapDisplay::blendBands(const std::vector<bool>& shown, nav_msgs::OccupancyGrid& grid) const
+{
+  grid.info = band_grids_.front().info;
+  grid.data.assign(band_grids_.front().data.size(), -1);
+
+  // like within a band, occupied wins over free and free over unknown
+  for (std::size_t b = 0; b < band_grids_.size(); ++b)
+  {
+    if (b >= shown.size() || !shown[b])
+      continue;
+
+    const std::vector<int8_t>& data = band_grids_[b].data;
+    for (std::size_t i = 0; i < data.size() && i < grid.data.size(); ++i)
+      grid.data[i] = std::max(grid.data[i], data[i]);
+  }
 }
 
 void OccupancyMapDisplay::updateTopic()
@@ -105,7 +437,7 @@ void OccupancyMapDisplay::subscribe()
 
       sub_.reset(new message_filters::Subscriber<octomap_msgs::Octomap>());
 
-      sub_->subscribe(threaded_nh_, topicStr, 5);
+      sub_->subscribe(threaded_nh_, topicStr, queue_size_);
       sub_->registerCallback(boost::bind(&OccupancyMapDisplay::handleOctomapBinaryMessage, this, _1));
 
     }
@@ -118,100 +450,378 @@ void OccupancyMapDisplay::subscribe()
 
 void OccupancyMapDisplay::unsubscribe()
 {
-  clear();
-
   try
   {
-    // reset filters
+    // reset filters first, the subscriber waits for a running callback, so
+    // no message queues a new task while the state below is cleared
     sub_.reset();
   }
   catch (ros::Exception& e)
   {
     setStatus(StatusProperty::Error, "Topic", (std::string("Error unsubscribing: ") + e.what()).c_str());
   }
+
+  work_queue_.cancel();
+  {
+    boost::mutex::scoped_lock lock(pending_mutex_);
+    pending_messages_.clear();
+  }
+  // no task is queued or running after cancel()
+  band_grids_.clear();
+  window_grids_.clear();
+  distance_transform_.clear();
+  octree_.clear();
+  {
+    boost::mutex::scoped_lock lock(window_mutex_);
+    map_frame_.clear();
+  }
+  {
+    boost::mutex::scoped_lock lock(clearance_mutex_);
+    clearance_points_.clear();
+    clearance_received_ = false;
+  }
+  if (clearance_cloud_)
+    clearance_cloud_->clear();
+  updateQueueStatus();
+
+  clear();
+}
+
+
+void OccupancyMapDisplay::update(float wall_dt, float ros_dt)
+{
+  rviz::MapDisplay::update(wall_dt, ros_dt);
+
+  // maps of displays in view are projected first
+  rviz::ViewController* view = context_->getViewManager()->getCurrent();
+  if (view && view->getCamera())
+  {
+    const Ogre::AxisAlignedBox& bounds = scene_node_->_getWorldAABB();
+    bool in_view = bounds.isNull() || view->getCamera()->isVisible(bounds);
+    work_queue_.setPriority(in_view ? WorkerPool::HIGH_PRIORITY : WorkerPool::LOW_PRIORITY);
+  }
+
+  updateWindowCenter();
+  showClearance();
 }
 
+void OccupancyMapDisplay::updateWindowCenter()
+{
+  if (!window_property_->getBool())
+    return;
+
+  std::string map_frame;
+  double cell_size;
+  {
+    boost::mutex::scoped_lock lock(window_mutex_);
+    map_frame = map_frame_;
+    cell_size = window_cell_size_;
+  }
+  if (map_frame.empty())
+    return;
+
+  // served from the frame manager cache, so this is cheap to do every frame
+  const std::string& window_frame = window_frame_property_->getFrameStd();
+  Ogre::Vector3 map_position, window_position;
+  Ogre::Quaternion map_orientation, window_orientation;
+  bool transform_ok = context_->getFrameManager()->getTransform(map_frame, ros::Time(), map_position,
+                                                                map_orientation)
+                      && context_->getFrameManager()->getTransform(window_frame, ros::Time(), window_position,
+                                                                   window_orientation);
+
+  // the status is only touched when the lookup starts or stops failing
+  if (transform_ok != window_transform_ok_)
+  {
+    window_transform_ok_ = transform_ok;
+    if (transform_ok)
+      deleteStatusStd("Rolling Window Transform");
+    else
+      setStatusStd(StatusProperty::Warn, "Rolling Window Transform",
+                   "Failed to transform from frame [" + window_frame + "] to frame [" + map_frame + "]");
+  }
+  if (!transform_ok)
+    return;
+
+  Ogre::Vector3 center = map_orientation.Inverse() * (window_position - map_position);
+  {
+    // the window moves in whole cells, smaller motions need no projection
+    boost::mutex::scoped_lock lock(window_mutex_);
+    if (window_center_valid_ && std::abs(center.x - window_center_[0]) < cell_size
+        && std::abs(center.y - window_center_[1]) < cell_size)
+      return;
+
+    window_center_[0] = center.x;
+    window_center_[1] = center.y;
+    window_center_valid_ = true;
+  }
+
+  work_queue_.submit(boost::bind(&OccupancyMapDisplay::shiftWindow, this));
+}
 
 void OccupancyMapDisplay::handleOctomapBinaryMessage(const octomap_msgs::OctomapConstPtr& msg)
 {
+  TraceScope trace("receive");
+
+  {
+    // like the subscriber queue, drop the oldest messages if projecting falls behind
+    boost::mutex::scoped_lock lock(pending_mutex_);
+    pending_messages_.push_back(msg);
+    while (pending_messages_.size() > queue_size_)
+      pending_messages_.pop_front();
+  }
+
+  work_queue_.submit(boost::bind(&OccupancyMapDisplay::processPendingMessage, this));
+  updateQueueStatus();
+}
+
+void OccupancyMapDisplay::processPendingMessage()
+{
+  octomap_msgs::OctomapConstPtr msg;
+  {
+    boost::mutex::scoped_lock lock(pending_mutex_);
+
+    // the message of this task may have been dropped
+    if (pending_messages_.empty())
+      return;
+
+    msg = pending_messages_.front();
+    pending_messages_.pop_front();
+  }
+
+  processMessage(msg);
+  updateQueueStatus();
+}
+
+void OccupancyMapDisplay::updateQueueStatus()
+{
+  std::size_t pending;
+  {
+    boost::mutex::scoped_lock lock(pending_mutex_);
+    pending = pending_messages_.size();
+  }
+
+  std::stringstream ss;
+  ss << pending << " messages pending, " << WorkerPool::instance().threadCount() << " shared worker threads";
+  setStatusStd(StatusProperty::Ok, "Queue", ss.str());
+}
+
+void OccupancyMapDisplay::processMessage(const octomap_msgs::OctomapConstPtr& msg)
+{
+  TraceScope trace("process");
 
   ROS_DEBUG("Received OctomapBinary message (size: %d bytes)", (int)msg->data.size());
 
-  // creating octree
-  octomap::OcTree* octomap = NULL;
-  octomap::AbstractOcTree* tree = octomap_msgs::msgToMap(*msg);
-  if (tree){
-    octomap = dynamic_cast<octomap::OcTree*>(tree);
+  // decoding octree into the reused node arena, it is kept to project it
+  // again when a setting changes
+  decode_allocations_ = AllocationCounter::Counts();
+  bool decoded;
+  {
+    TraceScope trace("decode");
+    AllocationScope allocations(decode_allocations_);
+    decoded = octree_.readMessage(*msg);
   }
 
-  if (!octomap)
+  if (!decoded)
   {
     this->setStatusStd(StatusProperty::Error, "Message", "Failed to create octree structure");
     return;
   }
 
-  // get dimensions of octree
-  double minX, minY, minZ, maxX, maxY, maxZ;
-  octomap->getMetricMin(minX, minY, minZ);
-  octomap->getMetricMax(maxX, maxY, maxZ);
-  octomap::point3d minPt = octomap::point3d(minX, minY, minZ);
+  map_header_ = msg->header;
+  {
+    boost::mutex::scoped_lock lock(window_mutex_);
+    map_frame_ = msg->header.frame_id;
+  }
 
-  unsigned int tree_depth = octomap->getTreeDepth();
+  memory_.set(MemoryAccounting::OCTREE, octree_.memoryUsage());
+  memory_.set(MemoryAccounting::MESSAGE_QUEUE, msg->data.size() * queue_size_);
 
-  octomap::OcTreeKey paddedMinKey = octomap->coordToKey(minPt);
+  projectMap();
+}
 
-  nav_msgs::OccupancyGrid::Ptr occupancy_map (new nav_msgs::OccupancyGrid());
+void OccupancyMapDisplay::reprojectMap()
+{
+  if (octree_.empty())
+    return;
 
-  unsigned int width, height;
-  double res;
+  TraceScope trace("reproject");
+  projectMap();
+}
 
-  unsigned int ds_shift = tree_depth-octree_depth_;
+void OccupancyMapDisplay::shiftWindow()
+{
+  if (octree_.empty())
+    return;
 
-  occupancy_map->header = msg->header;
-  occupancy_map->info.resolution = res = octomap->getNodeSize(octree_depth_);
-  occupancy_map->info.width = width = (maxX-minX) / res + 1;
-  occupancy_map->info.height = height = (maxY-minY) / res + 1;
-  occupancy_map->info.origin.position.x = minX  - (res / (float)(1<<ds_shift) ) + res;
-  occupancy_map->info.origin.position.y = minY  - (res / (float)(1<<ds_shift) );;
+  TraceScope trace("reproject");
+  projectMap(true);
+}
 
-  occupancy_map->data.clear();
-  occupancy_map->data.resize(width*height, -1);
+void OccupancyMapDisplay::projectMap(bool shift_window)
+{
+  std::vector<MapProjector::ZBand> bands;
+  std::vector<bool> shown_bands;
+  {
+    boost::mutex::scoped_lock lock(band_mutex_);
+    bands = z_bands_;
+    shown_bands = shown_bands_;
+  }
+
+  bool window = window_property_->getBool();
+  double window_size = window_size_property_->getFloat();
+  double window_center[2];
+  if (window)
+  {
+    boost::mutex::scoped_lock lock(window_mutex_);
+
+    // projected once the frame to follow is known
+    if (!window_center_valid_)
+    {
+      setStatusStd(StatusProperty::Warn, "Rolling Window", "Waiting for the transform of the window frame");
+      return;
+    }
+    window_center[0] = window_center_[0];
+    window_center[1] = window_center_[1];
+  }
+  else if (shift_window)
+  {
+    return;
+  }
 
-    // traverse all leafs in the tree:
-  unsigned int treeDepth = std::min<unsigned int>(octree_depth_, octomap->getTreeDepth());
-  for (octomap::OcTree::iterator it = octomap->begin(treeDepth), end = octomap->end(); it != end; ++it)
+  // degrade gracefully by reducing the tree depth until the grid (and its
+  // texture copy) fit into the memory limit. Without bands the window keeps
+  // a grid of its own to shift.
+  // the projection needs at least the root level, a stored config may hold
+  // any depth
+  unsigned int requested_depth = std::min<unsigned int>(std::max(1u, octree_depth_), octree_.getTreeDepth());
+  std::size_t memory_limit = static_cast<std::size_t>(memory_limit_property_->getInt()) << 20;
+  std::size_t fixed_bytes = memory_.current(MemoryAccounting::OCTREE) + memory_.current(MemoryAccounting::MESSAGE_QUEUE);
+  std::size_t bytes_per_cell = 2 + bands.size() + (window && bands.empty() ? 1 : 0);
+  unsigned int octree_depth = MapProjector::fitDepth(octree_, requested_depth, fixed_bytes, memory_limit,
+                                                     bytes_per_cell, window ? window_size : 0.0);
+
+  if (octree_depth < requested_depth)
+  {
+    std::stringstream ss;
+    ss << "Reduced octree depth from " << requested_depth << " to " << octree_depth << " to stay within "
+       << MemoryAccounting::formatBytes(memory_limit);
+    this->setStatusStd(StatusProperty::Warn, "Memory Limit", ss.str());
+  }
+  else
   {
-    bool occupied = octomap->isNodeOccupied(*it);
-    int intSize = 1 << (octree_depth_ - it.getDepth());
+    deleteStatusStd("Memory Limit");
+  }
+
+  nav_msgs::OccupancyGrid::Ptr occupancy_map (new nav_msgs::OccupancyGrid());
 
-    octomap::OcTreeKey minKey=it.getIndexKey();
+  occupancy_map->header = map_header_;
 
-    for (int dx = 0; dx < intSize; dx++)
+  AllocationCounter::Counts project_allocations;
+  {
+    TraceScope trace("project");
+    AllocationScope allocations(project_allocations);
+
+    int projection = projection_property_->getOptionInt();
+    if (window)
     {
-      for (int dy = 0; dy < intSize; dy++)
+      // the window always uses the summary traversal, which gives the same
+      // grid as the leaf projection
+      std::vector<MapProjector::ZBand> window_bands = bands;
+      if (window_bands.empty())
       {
-        int posX = std::max<int>(0, minKey[0] + dx - paddedMinKey[0]);
-        posX>>=ds_shift;
+        window_bands.resize(1);
+        window_bands[0].min_z = -std::numeric_limits<double>::infinity();
+        window_bands[0].max_z = std::numeric_limits<double>::infinity();
+      }
 
-        int posY = std::max<int>(0, minKey[1] + dy - paddedMinKey[1]);
-        posY>>=ds_shift;
+      std::vector<nav_msgs::OccupancyGrid>& window_grids = bands.empty() ? window_grids_ : band_grids_;
+      window_grids.resize(window_bands.size());
+      if (!bands.empty())
+        window_grids_.clear();
+      else
+        band_grids_.clear();
 
-        int idx = width * posY + posX;
+      std::vector<nav_msgs::OccupancyGrid*> grids;
+      for (std::size_t b = 0; b < window_grids.size(); ++b)
+        grids.push_back(&window_grids[b]);
 
-        if (occupied)
-          occupancy_map->data[idx] = 100;
-        else if (occupancy_map->data[idx] == -1)
-        {
-          occupancy_map->data[idx] = 0;
-        }
+      std::size_t projected = MapProjector::projectWindow(octree_, octree_depth,
+                                                          projection == OCTOMAP_PROBABILITY_PROJECTION,
+                                                          window_bands, grids, window_center[0], window_center[1],
+                                                          window_size, shift_window);
+      if (shift_window && !projected)
+        return;
 
+      {
+        boost::mutex::scoped_lock lock(window_mutex_);
+        window_cell_size_ = window_grids.front().info.resolution;
       }
+
+      std::stringstream ss;
+      ss << "Projected " << projected << " of " << window_grids.front().data.size() << " cells";
+      setStatusStd(StatusProperty::Ok, "Rolling Window", ss.str());
+
+      if (bands.empty())
+        *occupancy_map = window_grids_.front();
+      else
+        blendBands(shown_bands, *occupancy_map);
+      occupancy_map->header = map_header_;
     }
+    else if (!bands.empty())
+    {
+      // all bands in one traversal, they are kept to change the shown ones
+      // without projecting again
+      window_grids_.clear();
+      band_grids_.resize(bands.size());
+      std::vector<nav_msgs::OccupancyGrid*> grids;
+      for (std::size_t b = 0; b < band_grids_.size(); ++b)
+        grids.push_back(&band_grids_[b]);
+
+      MapProjector::projectBands(octree_, octree_depth, projection == OCTOMAP_PROBABILITY_PROJECTION, bands, grids);
+      blendBands(shown_bands, *occupancy_map);
+    }
+    else
+    {
+      band_grids_.clear();
+      window_grids_.clear();
 
+      switch (projection)
+      {
+        case OCTOMAP_SUMMARY_PROJECTION:
+          MapProjector::projectSummaries(octree_, octree_depth, false, *occupancy_map);
+          break;
+        case OCTOMAP_PROBABILITY_PROJECTION:
+          MapProjector::projectSummaries(octree_, octree_depth, true, *occupancy_map);
+          break;
+        default:
+          MapProjector::project(octree_, octree_depth, *occupancy_map);
+          break;
+      }
+    }
   }
 
-  delete octomap;
+  if (!window)
+    deleteStatusStd("Rolling Window");
+
+  std::size_t clearance_cells = updateClearance(*occupancy_map);
+
+  // the map display keeps a copy of the grid and uploads one byte per cell
+  // into a texture, the clearance overlay one point per shaded cell
+  memory_.set(MemoryAccounting::OCCUPANCY_GRID,
+              occupancy_map->data.size() * (1 + band_grids_.size() + window_grids_.size())
+              + distance_transform_.memoryUsage());
+  memory_.set(MemoryAccounting::RENDER_BUFFERS,
+              occupancy_map->data.size() + clearance_cells * sizeof(rviz::PointCloud::Point));
+  setStatusStd(StatusProperty::Ok, "Memory", memory_.summary());
+
+  // only reported if the counting allocator hook is preloaded
+  if (AllocationCounter::available())
+  {
+    setStatusStd(StatusProperty::Ok, "Allocations", "decode: " + AllocationCounter::format(decode_allocations_) +
+                 ", projection: " + AllocationCounter::format(project_allocations));
+  }
 
+  TraceScope handoff_trace("handoff");
   this->incomingMap(occupancy_map);
 }
 
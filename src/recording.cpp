@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "octomap_rviz_plugins/recording.h"
+
+#include <stdint.h>
+#include <cstring>
+
+namespace octomap_rviz_plugin
+{
+
+static const char recording_magic_[8] = { 'O', 'C', 'T', 'R', 'E', 'C', '0', '1' };
+
+// upper bound for a single string or payload, protects against reading
+// garbage lengths from truncated files
+static const uint32_t max_field_size_ = 1u << 30;
+
+template <typename T>
+static void writeValue(std::ostream& s, const T& value)
+{
+  s.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool readValue(std::istream& s, T& value)
+{
+  return static_cast<bool>(s.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+static void writeString(std::ostream& s, const std::string& str)
+{
+  writeValue(s, static_cast<uint32_t>(str.size()));
+  s.write(str.data(), str.size());
+}
+
+static bool readString(std::istream& s, std::string& str)
+{
+  uint32_t size;
+  if (!readValue(s, size) || size > max_field_size_)
+    return false;
+
+  str.resize(size);
+  return size == 0 || static_cast<bool>(s.read(&str[0], size));
+}
+
+bool RecordingWriter::open(const std::string& path)
+{
+  close();
+
+  stream_.open(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!stream_.is_open())
+    return false;
+
+  stream_.write(recording_magic_, sizeof(recording_magic_));
+  return static_cast<bool>(stream_);
+}
+
+void RecordingWriter::close()
+{
+  if (stream_.is_open())
+    stream_.close();
+  stream_.clear();
+}
+
+bool RecordingWriter::write(const RecordedFrame& frame)
+{
+  if (!stream_.is_open())
+    return false;
+
+  writeValue(stream_, frame.receive_time);
+  stream_.write(reinterpret_cast<const char*>(frame.map_position), sizeof(frame.map_position));
+  stream_.write(reinterpret_cast<const char*>(frame.map_orientation), sizeof(frame.map_orientation));
+  stream_.write(reinterpret_cast<const char*>(frame.camera_position), sizeof(frame.camera_position));
+  stream_.write(reinterpret_cast<const char*>(frame.camera_orientation), sizeof(frame.camera_orientation));
+
+  const octomap_msgs::Octomap& msg = frame.message;
+  writeValue(stream_, static_cast<uint32_t>(msg.header.seq));
+  writeValue(stream_, static_cast<uint32_t>(msg.header.stamp.sec));
+  writeValue(stream_, static_cast<uint32_t>(msg.header.stamp.nsec));
+  writeString(stream_, msg.header.frame_id);
+  writeValue(stream_, static_cast<uint8_t>(msg.binary));
+  writeString(stream_, msg.id);
+  writeValue(stream_, static_cast<double>(msg.resolution));
+  writeValue(stream_, static_cast<uint32_t>(msg.data.size()));
+  if (!msg.data.empty())
+    stream_.write(reinterpret_cast<const char*>(&msg.data[0]), msg.data.size());
+
+  stream_.flush();
+  return static_cast<bool>(stream_);
+}
+
+bool RecordingReader::open(const std::string& path)
+{
+  close();
+
+  stream_.open(path.c_str(), std::ios::in | std::ios::binary);
+  if (!stream_.is_open())
+    return false;
+
+  char magic[sizeof(recording_magic_)];
+  if (!stream_.read(magic, sizeof(magic)) || std::memcmp(magic, recording_magic_, sizeof(magic)) != 0)
+  {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+void RecordingReader::close()
+{
+  if (stream_.is_open())
+    stream_.close();
+  stream_.clear();
+}
+
+bool RecordingReader::read(RecordedFrame& frame)
+{
+  if (!stream_.is_open())
+    return false;
+
+  if (!readValue(stream_, frame.receive_time))
+    return false;
+
+  stream_.read(reinterpret_cast<char*>(frame.map_position), sizeof(frame.map_position));
+  stream_.read(reinterpret_cast<char*>(frame.map_orientation), sizeof(frame.map_orientation));
+  stream_.read(reinterpret_cast<char*>(frame.camera_position), sizeof(frame.camera_position));
+  stream_.read(reinterpret_cast<char*>(frame.camera_orientation), sizeof(frame.camera_orientation));
+
+  octomap_msgs::Octomap& msg = frame.message;
+  uint32_t seq, sec, nsec, size;
+  uint8_t binary;
+  double resolution;
+  if (!readValue(stream_, seq) || !readValue(stream_, sec) || !readValue(stream_, nsec) ||
+      !readString(stream_, msg.header.frame_id) || !readValue(stream_, binary) || !readString(stream_, msg.id) ||
+      !readValue(stream_, resolution) || !readValue(stream_, size) || size > max_field_size_)
+    return false;
+
+  msg.header.seq = seq;
+  msg.header.stamp.sec = sec;
+  msg.header.stamp.nsec = nsec;
+  msg.binary = binary;
+  msg.resolution = resolution;
+
+  msg.data.resize(size);
+  return size == 0 || static_cast<bool>(stream_.read(reinterpret_cast<char*>(&msg.data[0]), size));
+}
+
+} // namespace octomap_rviz_plugin
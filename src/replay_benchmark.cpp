@@ -0,0 +1,622 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Replays a recording made with the "Record File" property of the
+// OccupancyGrid display through the decoding, voxel extraction and map
+// projection pipelines without rviz and reports per-message latencies.
+//
+// With --synthetic the pipelines run on generated maps instead. Their output
+// checksums and throughput can be stored with --write-baseline and compared
+// later with --check, which exits non-zero if an output changed. Throughput
+// depends on the machine and is only compared if --tolerance is given.
+
+#include "octomap_rviz_plugins/allocation_counter.h"
+#include "octomap_rviz_plugins/arena_octree.h"
+#include "octomap_rviz_plugins/map_projector.h"
+#include "octomap_rviz_plugins/recording.h"
+#include "octomap_rviz_plugins/synthetic_map.h"
+#include "octomap_rviz_plugins/tracing.h"
+#include "octomap_rviz_plugins/voxel_extractor.h"
+
+#include <ros/ros.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace octomap_rviz_plugin;
+
+namespace
+{
+
+enum Stage
+{
+  DECODE,
+  EXTRACT_OCCUPIED,
+  EXTRACT_FREE,
+  PROJECT,
+  TOTAL,
+  NUM_STAGES
+};
+
+enum Projection
+{
+  LEAF_PROJECTION,
+  SUMMARY_PROJECTION,
+  PROBABILITY_PROJECTION
+};
+
+const char* stage_names_[NUM_STAGES] = { "decode", "extract occupied", "extract free", "project", "total" };
+
+struct Options
+{
+  Options() :
+      realtime(false),
+      repeat(1),
+      max_depth(std::numeric_limits<unsigned int>::max()),
+      color_mode(VoxelExtractor::Z_AXIS_COLOR),
+      merge_tolerance(0.0),
+      projection(LEAF_PROJECTION),
+      max_voxels(0),
+      synthetic(false),
+      size(64),
+      tolerance(-1.0)
+  {
+  }
+
+  bool realtime;
+  int repeat;
+  unsigned int max_depth;
+  VoxelExtractor::ColorMode color_mode;
+  double merge_tolerance;
+  Projection projection;
+  // extract only this many voxels nearest to the camera, 0 extracts all
+  std::size_t max_voxels;
+  std::string path;
+
+  bool synthetic;
+  unsigned int size;
+  double tolerance;
+  std::string write_baseline;
+  std::string check_baseline;
+  std::string trace;
+};
+
+// pipeline state reused across messages, like in the displays
+struct Pipeline
+{
+  ArenaOcTree octree;
+  VoxelExtractor extractor;
+  VoxelExtractor::VVPoint points;
+  nav_msgs::OccupancyGrid grid;
+
+  // allocations per stage summed over all messages
+  AllocationCounter::Counts allocations[NUM_STAGES];
+};
+
+// golden result and throughput of one synthetic scene
+struct Baseline
+{
+  uint64_t checksum;
+  double messages_per_second;
+};
+
+void printUsage(const char* name)
+{
+  std::fprintf(stderr,
+               "usage: %s [options] <recording>\n"
+               "       %s --synthetic [options]\n"
+               "  --realtime            replay with the recorded message timing instead of at maximum speed\n"
+               "  --repeat N            replay the recording or each synthetic map N times (default 1)\n"
+               "  --depth N             maximum octree depth (default: full depth)\n"
+               "  --color z|prob        voxel coloring mode (default z)\n"
+               "  --merge F             merge uniform subtrees within this color tolerance (default 0)\n"
+               "  --projection leafs|summaries|prob\n"
+               "                        2D projection mode (default leafs)\n"
+               "  --max-voxels N        extract only the N voxels nearest to the recorded camera, or to\n"
+               "                        the map origin for synthetic maps (default: all voxels)\n"
+               "  --synthetic           run on generated maps instead of a recording\n"
+               "  --size N              edge length of the generated maps in voxels (default 64)\n"
+               "  --write-baseline FILE store checksums and throughput of the synthetic maps\n"
+               "  --check FILE          compare against a stored baseline, exit 1 on regressions\n"
+               "  --tolerance F         with --check, also fail on a relative throughput drop above F\n"
+               "  --trace FILE          write a Chrome trace of all pipeline stages\n",
+               name, name);
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    bool has_value = i + 1 < argc;
+    if (!std::strcmp(argv[i], "--realtime"))
+      options.realtime = true;
+    else if (!std::strcmp(argv[i], "--repeat") && has_value)
+      options.repeat = std::max(1, std::atoi(argv[++i]));
+    else if (!std::strcmp(argv[i], "--depth") && has_value)
+      options.max_depth = std::max(1, std::atoi(argv[++i]));
+    else if (!std::strcmp(argv[i], "--color") && has_value)
+      options.color_mode = !std::strcmp(argv[++i], "prob") ? VoxelExtractor::PROBABILITY_COLOR
+                                                           : VoxelExtractor::Z_AXIS_COLOR;
+    else if (!std::strcmp(argv[i], "--merge") && has_value)
+      options.merge_tolerance = std::max(0.0, std::atof(argv[++i]));
+    else if (!std::strcmp(argv[i], "--projection") && has_value)
+    {
+      ++i;
+      options.projection = !std::strcmp(argv[i], "summaries") ? SUMMARY_PROJECTION
+                           : !std::strcmp(argv[i], "prob") ? PROBABILITY_PROJECTION : LEAF_PROJECTION;
+    }
+    else if (!std::strcmp(argv[i], "--max-voxels") && has_value)
+      options.max_voxels = std::max(0, std::atoi(argv[++i]));
+    else if (!std::strcmp(argv[i], "--synthetic"))
+      options.synthetic = true;
+    else if (!std::strcmp(argv[i], "--size") && has_value)
+      options.size = std::max(2, std::atoi(argv[++i]));
+    else if (!std::strcmp(argv[i], "--write-baseline") && has_value)
+      options.write_baseline = argv[++i];
+    else if (!std::strcmp(argv[i], "--check") && has_value)
+      options.check_baseline = argv[++i];
+    else if (!std::strcmp(argv[i], "--tolerance") && has_value)
+      options.tolerance = std::atof(argv[++i]);
+    else if (!std::strcmp(argv[i], "--trace") && has_value)
+      options.trace = argv[++i];
+    else if (argv[i][0] != '-' && options.path.empty())
+      options.path = argv[i];
+    else
+      return false;
+  }
+
+  // the generated maps need a power of two edge length
+  if (options.size & (options.size - 1) || options.size > 1024)
+    return false;
+
+  return options.synthetic != !options.path.empty();
+}
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+  if (sorted.empty())
+    return 0.0;
+  std::size_t idx = static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+void printStats(const char* name, std::vector<double> samples)
+{
+  std::sort(samples.begin(), samples.end());
+
+  double sum = 0.0;
+  for (std::size_t i = 0; i < samples.size(); ++i)
+    sum += samples[i];
+  double mean = samples.empty() ? 0.0 : sum / samples.size();
+
+  std::printf("%-18s %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f\n", name,
+              samples.empty() ? 0.0 : samples.front(), mean, percentile(samples, 0.5),
+              percentile(samples, 0.9), percentile(samples, 0.99), samples.empty() ? 0.0 : samples.back());
+}
+
+void printLatencies(const std::vector<double>* latencies)
+{
+  std::printf("%-18s %9s %9s %9s %9s %9s %9s\n", "latency [ms]", "min", "mean", "p50", "p90", "p99", "max");
+  for (int i = 0; i < NUM_STAGES; ++i)
+    printStats(stage_names_[i], latencies[i]);
+}
+
+void printAllocations(const Pipeline& pipeline, std::size_t messages)
+{
+  if (!AllocationCounter::available())
+  {
+    std::printf("allocation counts need LD_PRELOAD=liboctomap_rviz_alloc_hook.so\n");
+    return;
+  }
+
+  std::printf("%-18s %12s %12s\n", "per message", "allocations", "bytes");
+  for (int i = 0; i < NUM_STAGES; ++i)
+  {
+    std::printf("%-18s %12.1f %12.0f\n", stage_names_[i],
+                messages ? double(pipeline.allocations[i].allocations) / messages : 0.0,
+                messages ? double(pipeline.allocations[i].bytes) / messages : 0.0);
+  }
+}
+
+// 64 bit FNV-1a
+void hashBytes(uint64_t& hash, const void* data, std::size_t size)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+}
+
+void hashPoints(uint64_t& hash, const VoxelExtractor::VVPoint& points)
+{
+  for (std::size_t i = 0; i < points.size(); ++i)
+  {
+    uint64_t count = points[i].size();
+    hashBytes(hash, &count, sizeof(count));
+    for (std::size_t j = 0; j < points[i].size(); ++j)
+    {
+      const rviz::PointCloud::Point& p = points[i][j];
+      float values[7] = { p.position.x, p.position.y, p.position.z, p.color.r, p.color.g, p.color.b, p.color.a };
+      hashBytes(hash, values, sizeof(values));
+    }
+  }
+}
+
+// position of the recorded camera in the map frame, the focus of the voxel
+// budget like the focus frame of the display
+void cameraFocus(const RecordedFrame& frame, double focus[3])
+{
+  double v[3];
+  for (int i = 0; i < 3; ++i)
+    v[i] = frame.camera_position[i] - frame.map_position[i];
+
+  // rotate by the inverse map orientation, v + 2w (u x v) + 2u x (u x v)
+  // with u the negated vector part
+  double w = frame.map_orientation[0];
+  double u[3] = { -frame.map_orientation[1], -frame.map_orientation[2], -frame.map_orientation[3] };
+  double t[3] = { 2.0 * (u[1] * v[2] - u[2] * v[1]), 2.0 * (u[2] * v[0] - u[0] * v[2]),
+                  2.0 * (u[0] * v[1] - u[1] * v[0]) };
+  focus[0] = v[0] + w * t[0] + u[1] * t[2] - u[2] * t[1];
+  focus[1] = v[1] + w * t[1] + u[2] * t[0] - u[0] * t[2];
+  focus[2] = v[2] + w * t[2] + u[0] * t[1] - u[1] * t[0];
+}
+
+// runs all pipeline stages on msg and stores their latencies in seconds,
+// folds the output into checksum if it is given; with a voxel budget the
+// voxels nearest to focus are extracted
+bool processMessage(const Options& options, const octomap_msgs::Octomap& msg, const double focus[3],
+                    Pipeline& pipeline, double* stage_time, std::size_t& voxels, uint64_t* checksum)
+{
+  TraceScope trace("receive");
+
+  ros::WallTime start = ros::WallTime::now();
+
+  bool decoded;
+  {
+    TraceScope decode_trace("decode");
+    AllocationScope allocations(pipeline.allocations[DECODE]);
+    decoded = pipeline.octree.readMessage(msg);
+  }
+
+  if (!decoded)
+    return false;
+
+  ros::WallTime stage_start = ros::WallTime::now();
+  stage_time[DECODE] = (stage_start - start).toSec();
+
+  unsigned int depth = std::min(options.max_depth, pipeline.octree.getTreeDepth());
+
+  double checksum_time = 0.0;
+
+  for (int set = 0; set < VoxelExtractor::NUM_VOXEL_SETS; ++set)
+  {
+    Stage stage = set == VoxelExtractor::OCCUPIED_SET ? EXTRACT_OCCUPIED : EXTRACT_FREE;
+
+    std::size_t point_count = 0;
+    {
+      AllocationScope allocations(pipeline.allocations[stage]);
+      VoxelExtractor::VoxelSet voxel_set = static_cast<VoxelExtractor::VoxelSet>(set);
+      if (options.max_voxels)
+        pipeline.extractor.extractNearest(pipeline.octree, voxel_set, depth, focus, options.max_voxels,
+                                          pipeline.points, point_count);
+      else
+        pipeline.extractor.extract(pipeline.octree, voxel_set, depth, std::numeric_limits<std::size_t>::max(),
+                                   pipeline.points, point_count);
+    }
+
+    ros::WallTime stage_end = ros::WallTime::now();
+    stage_time[stage] = (stage_end - stage_start).toSec();
+
+    voxels += point_count;
+    if (checksum)
+      hashPoints(*checksum, pipeline.points);
+
+    // hashing is not part of the pipeline
+    stage_start = ros::WallTime::now();
+    checksum_time += (stage_start - stage_end).toSec();
+  }
+
+  pipeline.grid.header = msg.header;
+  {
+    TraceScope project_trace("project");
+    AllocationScope allocations(pipeline.allocations[PROJECT]);
+    if (options.projection == LEAF_PROJECTION)
+      MapProjector::project(pipeline.octree, depth, pipeline.grid);
+    else
+      MapProjector::projectSummaries(pipeline.octree, depth, options.projection == PROBABILITY_PROJECTION,
+                                     pipeline.grid);
+  }
+
+  ros::WallTime end = ros::WallTime::now();
+  stage_time[PROJECT] = (end - stage_start).toSec();
+  stage_time[TOTAL] = (end - start).toSec() - checksum_time;
+
+  pipeline.allocations[TOTAL] = AllocationCounter::Counts();
+  for (int i = 0; i < TOTAL; ++i)
+  {
+    pipeline.allocations[TOTAL].allocations += pipeline.allocations[i].allocations;
+    pipeline.allocations[TOTAL].bytes += pipeline.allocations[i].bytes;
+  }
+
+  if (checksum && !pipeline.grid.data.empty())
+    hashBytes(*checksum, &pipeline.grid.data[0], pipeline.grid.data.size());
+
+  pipeline.octree.clear();
+  return true;
+}
+
+int replayRecording(const Options& options)
+{
+  Pipeline pipeline;
+  pipeline.extractor.setColorMode(options.color_mode);
+  pipeline.extractor.setMergeTolerance(options.merge_tolerance);
+
+  // latencies in milliseconds
+  std::vector<double> latencies[NUM_STAGES];
+  std::size_t voxels = 0;
+  std::size_t failed = 0;
+
+  for (int run = 0; run < options.repeat; ++run)
+  {
+    RecordingReader reader;
+    if (!reader.open(options.path))
+    {
+      std::fprintf(stderr, "failed to open recording %s\n", options.path.c_str());
+      return 1;
+    }
+
+    RecordedFrame frame;
+    ros::WallTime replay_start = ros::WallTime::now();
+
+    while (reader.read(frame))
+    {
+      if (options.realtime)
+      {
+        ros::WallDuration wait = (replay_start + ros::WallDuration(frame.receive_time)) - ros::WallTime::now();
+        if (wait.toSec() > 0.0)
+          wait.sleep();
+      }
+
+      double focus[3];
+      cameraFocus(frame, focus);
+
+      double stage_time[NUM_STAGES];
+      if (!processMessage(options, frame.message, focus, pipeline, stage_time, voxels, NULL))
+      {
+        ++failed;
+        continue;
+      }
+
+      for (int i = 0; i < NUM_STAGES; ++i)
+        latencies[i].push_back(stage_time[i] * 1000.0);
+    }
+  }
+
+  std::printf("%lu messages replayed, %lu failed to decode, %lu voxels extracted\n",
+              (unsigned long)latencies[TOTAL].size(), (unsigned long)failed, (unsigned long)voxels);
+  printLatencies(latencies);
+  printAllocations(pipeline, latencies[TOTAL].size());
+
+  return 0;
+}
+
+// name of a synthetic run in baseline files, includes everything that
+// changes the output
+std::string baselineKey(const Options& options, SyntheticMap::Scene scene)
+{
+  std::stringstream ss;
+  ss << SyntheticMap::sceneName(scene) << "_" << options.size << "_d";
+  if (options.max_depth == std::numeric_limits<unsigned int>::max())
+    ss << "full";
+  else
+    ss << options.max_depth;
+  ss << (options.color_mode == VoxelExtractor::PROBABILITY_COLOR ? "_prob" : "_z");
+  if (options.merge_tolerance > 0.0)
+    ss << "_m" << options.merge_tolerance;
+  if (options.max_voxels)
+    ss << "_v" << options.max_voxels;
+  // summaries give the same grid as leafs
+  if (options.projection == PROBABILITY_PROJECTION)
+    ss << "_pprob";
+  return ss.str();
+}
+
+bool readBaselines(const std::string& path, std::map<std::string, Baseline>& baselines)
+{
+  std::ifstream file(path.c_str());
+  if (!file.is_open())
+    return false;
+
+  std::string line;
+  while (std::getline(file, line))
+  {
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    std::stringstream ss(line);
+    std::string key;
+    Baseline baseline;
+    if (ss >> key >> std::hex >> baseline.checksum >> std::dec >> baseline.messages_per_second)
+      baselines[key] = baseline;
+  }
+  return true;
+}
+
+int runSynthetic(const Options& options)
+{
+  std::map<std::string, Baseline> reference;
+  if (!options.check_baseline.empty() && !readBaselines(options.check_baseline, reference))
+  {
+    std::fprintf(stderr, "failed to read baseline %s\n", options.check_baseline.c_str());
+    return 1;
+  }
+
+  std::map<std::string, Baseline> results;
+  bool regression = false;
+
+  for (int s = 0; s < SyntheticMap::NUM_SCENES; ++s)
+  {
+    SyntheticMap::Scene scene = static_cast<SyntheticMap::Scene>(s);
+    std::string key = baselineKey(options, scene);
+
+    octomap_msgs::Octomap msg;
+    SyntheticMap::generate(scene, options.size, 0.05, msg);
+
+    Pipeline pipeline;
+    pipeline.extractor.setColorMode(options.color_mode);
+    pipeline.extractor.setMergeTolerance(options.merge_tolerance);
+
+    std::vector<double> latencies[NUM_STAGES];
+    std::size_t voxels = 0;
+    uint64_t checksum = 14695981039346656037ull;
+    const double focus[3] = { 0.0, 0.0, 0.0 };
+
+    for (int run = 0; run < options.repeat; ++run)
+    {
+      double stage_time[NUM_STAGES];
+      uint64_t run_checksum = 14695981039346656037ull;
+      if (!processMessage(options, msg, focus, pipeline, stage_time, voxels, &run_checksum))
+      {
+        std::fprintf(stderr, "failed to decode synthetic map %s\n", key.c_str());
+        return 1;
+      }
+
+      // every run has to reproduce the first one
+      if (run == 0)
+        checksum = run_checksum;
+      else if (run_checksum != checksum)
+      {
+        std::printf("FAIL %s: output differs between runs\n", key.c_str());
+        regression = true;
+      }
+
+      for (int i = 0; i < NUM_STAGES; ++i)
+        latencies[i].push_back(stage_time[i] * 1000.0);
+    }
+
+    double total = 0.0;
+    for (std::size_t i = 0; i < latencies[TOTAL].size(); ++i)
+      total += latencies[TOTAL][i];
+
+    Baseline& result = results[key];
+    result.checksum = checksum;
+    result.messages_per_second = total > 0.0 ? latencies[TOTAL].size() * 1000.0 / total : 0.0;
+
+    std::printf("%s: %lu bytes, %lu voxels per run, checksum %016llx, %.2f messages/s\n", key.c_str(),
+                (unsigned long)msg.data.size(), (unsigned long)(voxels / options.repeat),
+                (unsigned long long)checksum, result.messages_per_second);
+    printLatencies(latencies);
+    printAllocations(pipeline, latencies[TOTAL].size());
+
+    if (!options.check_baseline.empty())
+    {
+      std::map<std::string, Baseline>::const_iterator it = reference.find(key);
+      if (it == reference.end())
+      {
+        std::printf("WARN %s: no baseline\n", key.c_str());
+      }
+      else
+      {
+        if (it->second.checksum != result.checksum)
+        {
+          std::printf("FAIL %s: checksum %016llx, expected %016llx\n", key.c_str(),
+                      (unsigned long long)result.checksum, (unsigned long long)it->second.checksum);
+          regression = true;
+        }
+        if (options.tolerance >= 0.0
+            && result.messages_per_second < it->second.messages_per_second * (1.0 - options.tolerance))
+        {
+          std::printf("FAIL %s: %.2f messages/s, baseline %.2f\n", key.c_str(), result.messages_per_second,
+                      it->second.messages_per_second);
+          regression = true;
+        }
+      }
+    }
+    std::printf("\n");
+  }
+
+  if (!options.write_baseline.empty())
+  {
+    // keep entries of other configurations
+    std::map<std::string, Baseline> baselines;
+    readBaselines(options.write_baseline, baselines);
+    for (std::map<std::string, Baseline>::const_iterator it = results.begin(); it != results.end(); ++it)
+      baselines[it->first] = it->second;
+
+    std::ofstream file(options.write_baseline.c_str());
+    file << "# scene_size_depth_color checksum messages_per_second\n";
+    for (std::map<std::string, Baseline>::const_iterator it = baselines.begin(); it != baselines.end(); ++it)
+    {
+      file << it->first << " " << std::hex << it->second.checksum << std::dec << " "
+           << it->second.messages_per_second << "\n";
+    }
+
+    if (!file)
+    {
+      std::fprintf(stderr, "failed to write baseline %s\n", options.write_baseline.c_str());
+      return 1;
+    }
+  }
+
+  return regression ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  Options options;
+  if (!parseOptions(argc, argv, options))
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  if (!options.trace.empty() && !Tracer::instance().start(options.trace))
+  {
+    std::fprintf(stderr, "failed to open trace file %s\n", options.trace.c_str());
+    return 1;
+  }
+
+  int result = options.synthetic ? runSynthetic(options) : replayRecording(options);
+
+  Tracer::instance().stop();
+  return result;
+}
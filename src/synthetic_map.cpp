@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "octomap_rviz_plugins/synthetic_map.h"
+
+#include <cmath>
+
+namespace octomap_rviz_plugin
+{
+
+static const unsigned int tree_depth_ = 16;
+static const unsigned int tree_center_ = 1 << (tree_depth_ - 1);
+
+const char* SyntheticMap::sceneName(Scene scene)
+{
+  switch (scene)
+  {
+    case ROOM:
+      return "room";
+    case TERRAIN:
+      return "terrain";
+    case NOISE:
+      return "noise";
+    default:
+      return "unknown";
+  }
+}
+
+void SyntheticMap::generate(Scene scene, unsigned int size, double resolution, octomap_msgs::Octomap& msg)
+{
+  // index 0 stands for unknown space
+  std::vector<BuildNode> nodes(1);
+  nodes[0].value = -1;
+
+  uint32_t root = build(scene, size, 0, 0, 0, 0, nodes);
+
+  msg.header.frame_id = "map";
+  msg.binary = true;
+  msg.id = "OcTree";
+  msg.resolution = resolution;
+  msg.data.clear();
+
+  // the binary encoding cannot represent a root leaf
+  if (root && nodes[root].value == 2)
+    encode(nodes, root, msg.data);
+}
+
+int SyntheticMap::classify(Scene scene, unsigned int size, unsigned int x, unsigned int y, unsigned int z)
+{
+  switch (scene)
+  {
+    case ROOM:
+    {
+      unsigned int height = size / 2;
+      if (z > height)
+        return -1;
+      if (z == 0 || z == height || x == 0 || y == 0 || x == size - 1 || y == size - 1)
+        return 1;
+
+      // a row of boxes standing on the floor
+      unsigned int box = size / 8;
+      for (unsigned int k = 0; k < 3; ++k)
+      {
+        unsigned int bx = box + k * 2 * box;
+        if (x >= bx && x < bx + box && y >= 2 * box && y < 3 * box && z <= box)
+          return 1;
+      }
+      return 0;
+    }
+    case TERRAIN:
+    {
+      const double pi = 3.14159265358979323846;
+      double h = size / 4.0 + size / 8.0 * std::sin(x * 4.0 * pi / size) * std::cos(y * 6.0 * pi / size);
+      int ground = static_cast<int>(h);
+      int zi = static_cast<int>(z);
+      if (zi > ground + static_cast<int>(size / 4))
+        return -1;
+      if (zi > ground)
+        return 0;
+      if (zi >= ground - 1)
+        return 1;
+      return -1;
+    }
+    case NOISE:
+    {
+      uint32_t h = (x * 73856093u) ^ (y * 19349663u) ^ (z * 83492791u);
+      h ^= h >> 13;
+      h *= 0x5bd1e995u;
+      h ^= h >> 15;
+      unsigned int r = h % 20;
+      if (r == 0)
+        return -1;
+      return r < 4 ? 1 : 0;
+    }
+    default:
+      return -1;
+  }
+}
+
+uint32_t SyntheticMap::build(Scene scene, unsigned int size, unsigned int depth, unsigned int x, unsigned int y,
+                             unsigned int z, std::vector<BuildNode>& nodes)
+{
+  unsigned int extent = 1 << (tree_depth_ - depth);
+  unsigned int min = tree_center_ - size / 2;
+  unsigned int max = tree_center_ + size / 2;
+
+  if (x + extent <= min || y + extent <= min || z + extent <= min || x >= max || y >= max || z >= max)
+    return 0;
+
+  BuildNode node;
+  for (unsigned int i = 0; i < 8; ++i)
+    node.children[i] = 0;
+
+  if (depth == tree_depth_)
+  {
+    node.value = classify(scene, size, x - min, y - min, z - min);
+    if (node.value < 0)
+      return 0;
+
+    nodes.push_back(node);
+    return nodes.size() - 1;
+  }
+
+  std::size_t mark = nodes.size();
+
+  unsigned int half = extent / 2;
+  for (unsigned int i = 0; i < 8; ++i)
+  {
+    node.children[i] = build(scene, size, depth + 1, x + ((i & 1) ? half : 0), y + ((i & 2) ? half : 0),
+                             z + ((i & 4) ? half : 0), nodes);
+  }
+
+  // prune eight equal leafs into their parent like octomap does
+  bool any = false;
+  bool uniform = true;
+  for (unsigned int i = 0; i < 8; ++i)
+  {
+    any |= node.children[i] != 0;
+    uniform &= node.children[i] != 0 && nodes[node.children[i]].value != 2 &&
+               nodes[node.children[i]].value == nodes[node.children[0]].value;
+  }
+
+  if (!any)
+    return 0;
+
+  if (uniform)
+  {
+    node.value = nodes[node.children[0]].value;
+    for (unsigned int i = 0; i < 8; ++i)
+      node.children[i] = 0;
+    nodes.resize(mark);
+  }
+  else
+  {
+    node.value = 2;
+  }
+
+  nodes.push_back(node);
+  return nodes.size() - 1;
+}
+
+void SyntheticMap::encode(const std::vector<BuildNode>& nodes, uint32_t index, std::vector<int8_t>& data)
+{
+  const BuildNode& node = nodes[index];
+
+  // two bits per child: 0 unknown, 1 free leaf, 2 occupied leaf, 3 inner node
+  uint8_t bits[2] = { 0, 0 };
+  for (unsigned int i = 0; i < 8; ++i)
+  {
+    if (!node.children[i])
+      continue;
+
+    int value = nodes[node.children[i]].value;
+    uint8_t code = value == 2 ? 3 : (value == 1 ? 2 : 1);
+    bits[i / 4] |= code << ((i % 4) * 2);
+  }
+  data.push_back(static_cast<int8_t>(bits[0]));
+  data.push_back(static_cast<int8_t>(bits[1]));
+
+  for (unsigned int i = 0; i < 8; ++i)
+  {
+    if (node.children[i] && nodes[node.children[i]].value == 2)
+      encode(nodes, node.children[i], data);
+  }
+}
+
+} // namespace octomap_rviz_plugin
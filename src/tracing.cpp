@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "octomap_rviz_plugins/tracing.h"
+
+#include <ros/time.h>
+
+#include <cstdlib>
+
+namespace octomap_rviz_plugin
+{
+
+// events are buffered and written in batches to keep file IO off the
+// pipelines
+static const std::size_t flush_events_ = 4096;
+
+Tracer& Tracer::instance()
+{
+  static Tracer tracer;
+  return tracer;
+}
+
+Tracer::Tracer() :
+    enabled_(false)
+{
+  const char* path = std::getenv("OCTOMAP_RVIZ_TRACE");
+  if (path && *path)
+    start(path);
+}
+
+Tracer::~Tracer()
+{
+  stop();
+}
+
+bool Tracer::start(const std::string& path)
+{
+  stop();
+
+  boost::mutex::scoped_lock lock(mutex_);
+
+  file_.open(path.c_str(), std::ios::out | std::ios::trunc);
+  if (!file_.is_open())
+    return false;
+
+  // the array format may be left unterminated, so a trace stays readable
+  // even if the process does not shut down cleanly
+  file_ << "[\n";
+  events_.reserve(flush_events_);
+  enabled_ = true;
+  return true;
+}
+
+void Tracer::stop()
+{
+  boost::mutex::scoped_lock lock(mutex_);
+
+  if (!file_.is_open())
+    return;
+
+  enabled_ = false;
+  flush();
+  file_ << "{}]\n";
+  file_.close();
+  file_.clear();
+}
+
+void Tracer::addEvent(const char* name, uint64_t begin, uint64_t end)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+
+  if (!enabled_)
+    return;
+
+  std::map<boost::thread::id, unsigned int>::iterator it = thread_ids_.find(boost::this_thread::get_id());
+  if (it == thread_ids_.end())
+    it = thread_ids_.insert(std::make_pair(boost::this_thread::get_id(), thread_ids_.size() + 1)).first;
+
+  Event event;
+  event.name = name;
+  event.begin = begin;
+  event.duration = end - begin;
+  event.thread = it->second;
+  events_.push_back(event);
+
+  if (events_.size() >= flush_events_)
+    flush();
+}
+
+uint64_t Tracer::now()
+{
+  return ros::WallTime::now().toNSec() / 1000;
+}
+
+void Tracer::flush()
+{
+  for (std::size_t i = 0; i < events_.size(); ++i)
+  {
+    const Event& e = events_[i];
+    file_ << "{\"name\":\"" << e.name << "\",\"cat\":\"octomap\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread
+          << ",\"ts\":" << e.begin << ",\"dur\":" << e.duration << "},\n";
+  }
+  events_.clear();
+  file_.flush();
+}
+
+} // namespace octomap_rviz_plugin
@@ -0,0 +1,543 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Author: Julius Kammerl (jkammerl@willowgarage.com)
+ *
+ */
+
+#include "octomap_rviz_plugins/voxel_extractor.h"
+#include "octomap_rviz_plugins/morton.h"
+#include "octomap_rviz_plugins/tracing.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace octomap_rviz_plugin
+{
+
+static const std::size_t max_octree_depth_ = sizeof(unsigned short) * 8;
+
+// subtrees of at most 8^3 voxels are merged, which bounds the leafs visited
+// for the probability test
+static const unsigned int max_merge_levels_ = 3;
+
+// occupancy class bit of a set, (int)isNodeOccupied() + 1 evaluates to 1 for
+// free voxels and 2 for occupied voxels
+static int setMask(VoxelExtractor::VoxelSet set)
+{
+  return set == VoxelExtractor::OCCUPIED_SET ? 2 : 1;
+}
+
+VoxelExtractor::VoxelExtractor() :
+    octree_(NULL),
+    min_z_(0.0),
+    max_z_(0.0),
+    voxel_buf_(max_octree_depth_),
+    color_mode_(Z_AXIS_COLOR),
+    color_factor_(0.8),
+    merge_tolerance_(0.0)
+{
+}
+
+std::size_t VoxelExtractor::memoryUsage() const
+{
+  std::size_t bytes = sort_buf_.capacity() * sizeof(Voxel) + candidates_.capacity() * sizeof(Candidate)
+                      + frontier_.capacity() * sizeof(FrontierNode);
+  for (std::size_t i = 0; i < voxel_buf_.size(); ++i)
+    bytes += voxel_buf_[i].capacity() * sizeof(Voxel);
+  return bytes;
+}
+
+std::size_t VoxelExtractor::bytesPerVoxel()
+{
+  return 2 * sizeof(Voxel);
+}
+
+void VoxelExtractor::begin(const ArenaOcTree& octree)
+{
+  for (std::size_t i = 0; i < max_octree_depth_; ++i)
+  {
+    voxel_buf_[i].clear();
+  }
+  candidates_.clear();
+  frontier_.clear();
+
+  octree_ = &octree;
+
+  double minX, minY, maxX, maxY;
+  octree.getMetricMin(minX, minY, min_z_);
+  octree.getMetricMax(maxX, maxY, max_z_);
+}
+
+// like the arena iterator, 0 or anything beyond the tree selects its full depth
+static unsigned int effectiveDepth(const ArenaOcTree& octree, unsigned int treeDepth)
+{
+  return (treeDepth == 0 || treeDepth > octree.getTreeDepth()) ? octree.getTreeDepth() : treeDepth;
+}
+
+bool VoxelExtractor::extract(const ArenaOcTree& octree, VoxelSet set, unsigned int treeDepth,
+                             std::size_t max_points, VVPoint& points, std::size_t& pointCount)
+{
+  treeDepth = effectiveDepth(octree, treeDepth);
+  begin(octree);
+  pointCount = 0;
+
+  // voxels are culled against neighbors of the same set only
+  int set_mask = setMask(set);
+
+  // subtrees which are completely filled with voxels counting as neighbors
+  // can only contribute voxels on their boundary
+  uint8_t solid_flags = (set == OCCUPIED_SET) ? ArenaOcTree::FLAG_UNIFORM_OCCUPIED : ArenaOcTree::FLAG_UNIFORM_FREE;
+
+  collectCandidates(octree.begin(treeDepth, solid_flags), treeDepth, solid_flags, set_mask);
+
+  return finish(set_mask, max_points, points, pointCount);
+}
+
+bool VoxelExtractor::extractRegion(const ArenaOcTree& octree, VoxelSet set, const ArenaOcTree::iterator& region,
+                                   unsigned int treeDepth, std::size_t max_points, VVPoint& points,
+                                   std::size_t& pointCount)
+{
+  treeDepth = effectiveDepth(octree, treeDepth);
+  begin(octree);
+  pointCount = 0;
+
+  int set_mask = setMask(set);
+  uint8_t solid_flags = (set == OCCUPIED_SET) ? ArenaOcTree::FLAG_UNIFORM_OCCUPIED : ArenaOcTree::FLAG_UNIFORM_FREE;
+
+  collectCandidates(octree.beginSubtree(region, treeDepth, solid_flags), treeDepth, solid_flags, set_mask);
+
+  return finish(set_mask, max_points, points, pointCount);
+}
+
+void VoxelExtractor::collectCandidates(ArenaOcTree::iterator it, unsigned int treeDepth, uint8_t solid_flags,
+                                       int set_mask)
+{
+  TraceScope trace("traverse");
+
+  // traverse all leafs in the tree:
+  for (ArenaOcTree::iterator end = octree_->end(); it != end; ++it)
+  {
+    if (it.getDepth() < treeDepth && it->hasChildren())
+    {
+      octomap::OcTreeKey solidMinKey = it.getIndexKey();
+      collectSolidSubtree(&*it, it.getKey(), it.getDepth(), treeDepth, solid_flags, solidMinKey,
+                          octree_->getTreeDepth() - it.getDepth(), set_mask);
+    }
+    else
+    {
+      addCandidate(*it, it.getKey(), it.getDepth(), set_mask);
+    }
+  }
+}
+
+bool VoxelExtractor::finish(int set_mask, std::size_t max_points, VVPoint& points, std::size_t& pointCount)
+{
+  bool complete;
+  {
+    TraceScope trace("cull");
+    complete = cullCandidates(set_mask, 0, max_points, pointCount);
+  }
+
+  if (complete)
+    colorVoxels(points);
+
+  octree_ = NULL;
+  return complete;
+}
+
+bool VoxelExtractor::extractNearest(const ArenaOcTree& octree, VoxelSet set, unsigned int treeDepth,
+                                    const double focus[3], std::size_t max_points, VVPoint& points,
+                                    std::size_t& pointCount)
+{
+  treeDepth = effectiveDepth(octree, treeDepth);
+  begin(octree);
+  pointCount = 0;
+
+  int set_mask = setMask(set);
+  uint8_t solid_flags = (set == OCCUPIED_SET) ? ArenaOcTree::FLAG_UNIFORM_OCCUPIED : ArenaOcTree::FLAG_UNIFORM_FREE;
+
+  bool complete = true;
+
+  if (octree.getRoot())
+  {
+    // the traversal includes the neighbor tests, which decide when the
+    // budget is used up
+    TraceScope trace("traverse");
+
+    pushFrontier(octree.getRoot(), octree.getRootKey(), 0, focus);
+
+    while (complete && !frontier_.empty())
+    {
+      std::pop_heap(frontier_.begin(), frontier_.end());
+      FrontierNode nearest = frontier_.back();
+      frontier_.pop_back();
+
+      std::size_t first = candidates_.size();
+
+      if (nearest.depth >= treeDepth || !nearest.node->hasChildren())
+      {
+        addCandidate(*nearest.node, nearest.key, nearest.depth, set_mask);
+      }
+      else if (nearest.node->hasFlags(solid_flags))
+      {
+        collectSolidSubtree(nearest.node, nearest.key, nearest.depth, treeDepth, solid_flags,
+                            octree.getIndexKey(nearest.key, nearest.depth),
+                            octree.getTreeDepth() - nearest.depth, set_mask);
+      }
+      else
+      {
+        ArenaOcTree::key_type centerOffsetKey = octree.getCenterOffsetKey(nearest.depth);
+        for (unsigned int i = 0; i < 8; ++i)
+        {
+          if (!nearest.node->childExists(i))
+            continue;
+
+          octomap::OcTreeKey childKey;
+          ArenaOcTree::computeChildKey(i, centerOffsetKey, nearest.key, childKey);
+          pushFrontier(octree.getNodeChild(nearest.node, i), childKey, nearest.depth + 1, focus);
+        }
+      }
+
+      complete = cullCandidates(set_mask, first, max_points, pointCount);
+    }
+  }
+
+  colorVoxels(points);
+
+  octree_ = NULL;
+  return complete;
+}
+
+void VoxelExtractor::pushFrontier(const ArenaOcTree::Node* node, const octomap::OcTreeKey& key,
+                                  unsigned int depth, const double focus[3])
+{
+  // distance between focus and the closest point of the node
+  double half_size = 0.5 * octree_->getNodeSize(depth);
+  double distance_squared = 0.0;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    double outside = std::max(0.0, std::fabs(focus[i] - octree_->keyToCoord(key[i], depth)) - half_size);
+    distance_squared += outside * outside;
+  }
+
+  FrontierNode entry;
+  entry.distance_squared = distance_squared;
+  entry.node = node;
+  entry.key = key;
+  entry.depth = depth;
+
+  frontier_.push_back(entry);
+  std::push_heap(frontier_.begin(), frontier_.end());
+}
+
+void VoxelExtractor::collectSolidSubtree(const ArenaOcTree::Node* node, const octomap::OcTreeKey& key,
+                                         unsigned int depth, unsigned int treeDepth, uint8_t solid_flags,
+                                         const octomap::OcTreeKey& solidMinKey, unsigned int solidLevel,
+                                         int set_mask)
+{
+  // nodes not touching the boundary of the enclosing solid subtree are
+  // surrounded by solid space and hidden without any lookup
+  unsigned int level = octree_->getTreeDepth() - depth;
+  octomap::OcTreeKey minKey = octree_->getIndexKey(key, depth);
+
+  bool onBoundary = false;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    onBoundary |= minKey[i] == solidMinKey[i];
+    onBoundary |= minKey[i] + (1 << level) == solidMinKey[i] + (1 << solidLevel);
+  }
+
+  if (!onBoundary)
+    return;
+
+  if (depth >= treeDepth || !node->hasChildren())
+  {
+    addCandidate(*node, key, depth, set_mask);
+    return;
+  }
+
+  // a solid node with a solid shell is hidden entirely, otherwise descend
+  // towards the surface
+  if (isShellSolid(key, depth, solid_flags))
+    return;
+
+  if (isMergeable(node, depth, treeDepth))
+  {
+    addCandidate(*node, key, depth, set_mask, true);
+    return;
+  }
+
+  ArenaOcTree::key_type centerOffsetKey = octree_->getCenterOffsetKey(depth);
+  for (unsigned int i = 0; i < 8; ++i)
+  {
+    octomap::OcTreeKey childKey;
+    ArenaOcTree::computeChildKey(i, centerOffsetKey, key, childKey);
+
+    collectSolidSubtree(octree_->getNodeChild(node, i), childKey, depth + 1, treeDepth, solid_flags,
+                        solidMinKey, solidLevel, set_mask);
+  }
+}
+
+bool VoxelExtractor::isShellSolid(const octomap::OcTreeKey& nKey, unsigned int depth, uint8_t solid_flags)
+{
+  int step = 1 << (octree_->getTreeDepth() - depth);
+
+  for (int dz = -1; dz <= 1; ++dz)
+  {
+    for (int dy = -1; dy <= 1; ++dy)
+    {
+      for (int dx = -1; dx <= 1; ++dx)
+      {
+        if (!dx && !dy && !dz)
+          continue;
+
+        octomap::OcTreeKey key;
+        key[0] = nKey[0] + dx * step;
+        key[1] = nKey[1] + dy * step;
+        key[2] = nKey[2] + dz * step;
+
+        // returns the neighbor of the same size or a larger leaf containing it
+        const ArenaOcTree::Node* node = octree_->search(key, depth);
+        if (!node || !node->hasFlags(solid_flags))
+          return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+bool VoxelExtractor::isMergeable(const ArenaOcTree::Node* node, unsigned int depth, unsigned int treeDepth) const
+{
+  if (merge_tolerance_ <= 0.0 || depth == 0 || treeDepth - depth > max_merge_levels_)
+    return false;
+
+  if (color_mode_ == Z_AXIS_COLOR)
+  {
+    // the merged voxel takes the color of its center, its voxels span a hue
+    // range proportional to its height
+    return max_z_ > min_z_ && color_factor_ * octree_->getNodeSize(depth) / (max_z_ - min_z_) <= merge_tolerance_;
+  }
+
+  float min_log_odds = node->getLogOdds();
+  float max_log_odds = min_log_odds;
+  return isWithinTolerance(node, depth, treeDepth, min_log_odds, max_log_odds);
+}
+
+bool VoxelExtractor::isWithinTolerance(const ArenaOcTree::Node* node, unsigned int depth, unsigned int treeDepth,
+                                       float& min_log_odds, float& max_log_odds) const
+{
+  if (depth >= treeDepth || !node->hasChildren())
+  {
+    min_log_odds = std::min(min_log_odds, node->getLogOdds());
+    max_log_odds = std::max(max_log_odds, node->getLogOdds());
+
+    // occupancy grows monotonically with the log-odds
+    double spread = 1.0 / (1.0 + std::exp(min_log_odds)) - 1.0 / (1.0 + std::exp(max_log_odds));
+    return spread <= merge_tolerance_;
+  }
+
+  for (unsigned int i = 0; i < 8; ++i)
+  {
+    if (node->childExists(i)
+        && !isWithinTolerance(octree_->getNodeChild(node, i), depth + 1, treeDepth, min_log_odds, max_log_odds))
+      return false;
+  }
+
+  return true;
+}
+
+void VoxelExtractor::addCandidate(const ArenaOcTree::Node& voxel, const octomap::OcTreeKey& key,
+                                  unsigned int depth, int set_mask, bool merged)
+{
+  // the left part evaluates to 1 for free voxels and 2 for occupied voxels.
+  // Voxels are buffered per depth starting at 1, a lone root is not shown.
+  if (depth == 0 || !(((int)octree_->isNodeOccupied(voxel) + 1) & set_mask))
+    return;
+
+  Candidate candidate;
+  candidate.node = &voxel;
+  candidate.key = key;
+  candidate.depth = depth;
+  candidate.merged = merged;
+  candidates_.push_back(candidate);
+}
+
+bool VoxelExtractor::cullCandidates(int set_mask, std::size_t first, std::size_t max_points,
+                                    std::size_t& pointCount)
+{
+  for (std::size_t i = first; i < candidates_.size(); ++i)
+  {
+    const Candidate& candidate = candidates_[i];
+    const octomap::OcTreeKey& nKey = candidate.key;
+
+    // check if current voxel has neighbors on all sides -> no need to be displayed
+    bool allNeighborsFound = !candidate.merged;
+
+    octomap::OcTreeKey key;
+
+    for (key[2] = nKey[2] - 1; allNeighborsFound && key[2] <= nKey[2] + 1; ++key[2])
+    {
+      for (key[1] = nKey[1] - 1; allNeighborsFound && key[1] <= nKey[1] + 1; ++key[1])
+      {
+        for (key[0] = nKey[0] - 1; allNeighborsFound && key[0] <= nKey[0] + 1; ++key[0])
+        {
+          if (key != nKey)
+          {
+            const ArenaOcTree::Node* node = octree_->search(key);
+
+            // the left part evaluates to 1 for free voxels and 2 for occupied voxels
+            if (!(node && (((int)octree_->isNodeOccupied(node)) + 1) & set_mask))
+            {
+              // we do not have a neighbor => break!
+              allNeighborsFound = false;
+            }
+          }
+        }
+      }
+    }
+
+    if (allNeighborsFound)
+      continue;
+
+    if (pointCount == max_points)
+      return false;
+
+    Voxel newVoxel;
+
+    octomap::OcTreeKey indexKey = octree_->getIndexKey(nKey, candidate.depth);
+    newVoxel.code = mortonEncode(indexKey[0], indexKey[1], indexKey[2]);
+
+    for (unsigned int j = 0; j < 3; ++j)
+      newVoxel.position[j] = octree_->keyToCoord(nKey[j], candidate.depth);
+    newVoxel.log_odds = candidate.node->getLogOdds();
+
+    // push to point vectors
+    voxel_buf_[candidate.depth - 1].push_back(newVoxel);
+
+    ++pointCount;
+  }
+
+  return true;
+}
+
+void VoxelExtractor::colorVoxels(VVPoint& points)
+{
+  // bring the voxels of every depth into Z-order so that spatially close
+  // voxels are also close in memory
+  {
+    TraceScope trace("sort");
+
+    for (std::size_t i = 0; i < max_octree_depth_; ++i)
+      mortonRadixSort(voxel_buf_[i], sort_buf_);
+  }
+
+  TraceScope trace("color");
+
+  points.resize(max_octree_depth_);
+
+  for (std::size_t i = 0; i < max_octree_depth_; ++i)
+  {
+    points[i].resize(voxel_buf_[i].size());
+    for (std::size_t j = 0; j < voxel_buf_[i].size(); ++j)
+    {
+      const Voxel& voxel = voxel_buf_[i][j];
+      rviz::PointCloud::Point& newPoint = points[i][j];
+
+      newPoint.position.x = voxel.position[0];
+      newPoint.position.y = voxel.position[1];
+      newPoint.position.z = voxel.position[2];
+
+      float cell_probability;
+
+      switch (color_mode_)
+      {
+        case Z_AXIS_COLOR:
+          setColor(newPoint.position.z, min_z_, max_z_, color_factor_, newPoint);
+          break;
+        case PROBABILITY_COLOR:
+          cell_probability = 1.0 - (1.0 / (1.0 + std::exp(voxel.log_odds)));
+          newPoint.setColor((1.0f-cell_probability), cell_probability, 0.0);
+          break;
+        default:
+          break;
+      }
+    }
+  }
+}
+
+void VoxelExtractor::setColor(double z_pos, double min_z, double max_z, double color_factor,
+                              rviz::PointCloud::Point& point)
+{
+  int i;
+  double m, n, f;
+
+  double s = 1.0;
+  double v = 1.0;
+
+  double h = (1.0 - std::min(std::max((z_pos - min_z) / (max_z - min_z), 0.0), 1.0)) * color_factor;
+
+  h -= floor(h);
+  h *= 6;
+  i = floor(h);
+  f = h - i;
+  if (!(i & 1))
+    f = 1 - f; // if i is even
+  m = v * (1 - s);
+  n = v * (1 - s * f);
+
+  switch (i)
+  {
+    case 6:
+    case 0:
+      point.setColor(v, n, m);
+      break;
+    case 1:
+      point.setColor(n, v, m);
+      break;
+    case 2:
+      point.setColor(m, v, n);
+      break;
+    case 3:
+      point.setColor(m, n, v);
+      break;
+    case 4:
+      point.setColor(n, m, v);
+      break;
+    case 5:
+      point.setColor(v, m, n);
+      break;
+    default:
+      point.setColor(1, 0.5, 0.5);
+      break;
+  }
+}
+
+} // namespace octomap_rviz_plugin
@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "octomap_rviz_plugins/worker_pool.h"
+
+#include <boost/bind.hpp>
+
+#include <ros/ros.h>
+
+#include <algorithm>
+#include <exception>
+
+namespace octomap_rviz_plugin
+{
+
+static std::size_t defaultThreadCount()
+{
+  unsigned int cores = boost::thread::hardware_concurrency();
+  return cores > 1 ? cores - 1 : 1;
+}
+
+WorkerPool::Queue::Queue() :
+    priority_(HIGH_PRIORITY),
+    scheduled_(false),
+    running_(false)
+{
+}
+
+WorkerPool::Queue::~Queue()
+{
+  cancel();
+}
+
+void WorkerPool::Queue::submit(const Task& task)
+{
+  WorkerPool& pool = instance();
+  boost::mutex::scoped_lock lock(pool.mutex_);
+
+  tasks_.push_back(task);
+  if (!scheduled_ && !running_)
+    pool.schedule(this);
+}
+
+void WorkerPool::Queue::setPriority(Priority priority)
+{
+  WorkerPool& pool = instance();
+  boost::mutex::scoped_lock lock(pool.mutex_);
+
+  if (priority == priority_)
+    return;
+
+  if (scheduled_)
+  {
+    pool.unschedule(this);
+    priority_ = priority;
+    pool.schedule(this);
+  }
+  else
+  {
+    priority_ = priority;
+  }
+}
+
+void WorkerPool::Queue::cancel()
+{
+  WorkerPool& pool = instance();
+  boost::mutex::scoped_lock lock(pool.mutex_);
+
+  tasks_.clear();
+  if (scheduled_)
+    pool.unschedule(this);
+
+  while (running_)
+    idle_.wait(lock);
+}
+
+std::size_t WorkerPool::Queue::depth() const
+{
+  boost::mutex::scoped_lock lock(instance().mutex_);
+  return tasks_.size() + (running_ ? 1 : 0);
+}
+
+WorkerPool& WorkerPool::instance()
+{
+  static WorkerPool pool;
+  return pool;
+}
+
+WorkerPool::WorkerPool() :
+    next_worker_(0),
+    stopping_(false)
+{
+  // workers check their index against threads_ as soon as they run
+  boost::mutex::scoped_lock lock(mutex_);
+  start(defaultThreadCount());
+}
+
+WorkerPool::~WorkerPool()
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  stop(lock);
+}
+
+void WorkerPool::setThreadCount(unsigned int threads)
+{
+  std::size_t count = threads ? threads : defaultThreadCount();
+
+  boost::mutex::scoped_lock lock(mutex_);
+  reapRetired();
+  if (count == threads_.size())
+    return;
+
+  if (count > threads_.size())
+  {
+    for (int priority = 0; priority < NUM_PRIORITIES; ++priority)
+      ready_[priority].resize(count);
+    for (std::size_t worker = threads_.size(); worker < count; ++worker)
+      threads_.push_back(new boost::thread(boost::bind(&WorkerPool::run, this, worker)));
+    return;
+  }
+
+  // surplus workers finish their running task and exit on their own, so the
+  // caller, usually the GUI thread, does not wait for them. Their queued work
+  // is handed to the remaining workers.
+  std::vector<Queue*> ready;
+  for (int priority = 0; priority < NUM_PRIORITIES; ++priority)
+  {
+    for (std::size_t worker = count; worker < ready_[priority].size(); ++worker)
+      ready.insert(ready.end(), ready_[priority][worker].begin(), ready_[priority][worker].end());
+    ready_[priority].resize(count);
+  }
+
+  retired_threads_.insert(retired_threads_.end(), threads_.begin() + count, threads_.end());
+  threads_.resize(count);
+
+  for (std::size_t i = 0; i < ready.size(); ++i)
+  {
+    ready[i]->scheduled_ = false;
+    schedule(ready[i]);
+  }
+  work_.notify_all();
+}
+
+unsigned int WorkerPool::threadCount() const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return threads_.size();
+}
+
+void WorkerPool::schedule(Queue* queue)
+{
+  std::vector<std::deque<Queue*> >& ready = ready_[queue->priority_];
+
+  // follow-up work stays with the worker that produced it
+  std::size_t worker = currentWorker();
+  if (worker >= ready.size())
+    worker = next_worker_++ % ready.size();
+
+  ready[worker].push_back(queue);
+  queue->scheduled_ = true;
+  work_.notify_all();
+}
+
+void WorkerPool::unschedule(Queue* queue)
+{
+  std::vector<std::deque<Queue*> >& ready = ready_[queue->priority_];
+  for (std::size_t worker = 0; worker < ready.size(); ++worker)
+    ready[worker].erase(std::remove(ready[worker].begin(), ready[worker].end(), queue), ready[worker].end());
+
+  queue->scheduled_ = false;
+}
+
+WorkerPool::Queue* WorkerPool::take(std::size_t worker)
+{
+  for (int priority = 0; priority < NUM_PRIORITIES; ++priority)
+  {
+    std::vector<std::deque<Queue*> >& ready = ready_[priority];
+
+    // own work in order first, then steal the newest work of the others
+    if (!ready[worker].empty())
+    {
+      Queue* queue = ready[worker].front();
+      ready[worker].pop_front();
+      return queue;
+    }
+
+    for (std::size_t i = 1; i < ready.size(); ++i)
+    {
+      std::deque<Queue*>& victim = ready[(worker + i) % ready.size()];
+      if (!victim.empty())
+      {
+        Queue* queue = victim.back();
+        victim.pop_back();
+        return queue;
+      }
+    }
+  }
+
+  return NULL;
+}
+
+std::size_t WorkerPool::currentWorker() const
+{
+  boost::thread::id id = boost::this_thread::get_id();
+  for (std::size_t worker = 0; worker < threads_.size(); ++worker)
+  {
+    if (threads_[worker]->get_id() == id)
+      return worker;
+  }
+  return threads_.size();
+}
+
+void WorkerPool::start(std::size_t threads)
+{
+  stopping_ = false;
+  next_worker_ = 0;
+
+  for (int priority = 0; priority < NUM_PRIORITIES; ++priority)
+  {
+    ready_[priority].clear();
+    ready_[priority].resize(threads);
+  }
+
+  for (std::size_t worker = 0; worker < threads; ++worker)
+    threads_.push_back(new boost::thread(boost::bind(&WorkerPool::run, this, worker)));
+}
+
+void WorkerPool::stop(boost::mutex::scoped_lock& lock)
+{
+  // the deques keep their size meanwhile, so work can still be scheduled
+  stopping_ = true;
+  work_.notify_all();
+
+  std::vector<boost::thread*> threads;
+  threads.swap(threads_);
+  threads.insert(threads.end(), retired_threads_.begin(), retired_threads_.end());
+  retired_threads_.clear();
+  exited_threads_.clear();
+
+  lock.unlock();
+  for (std::size_t i = 0; i < threads.size(); ++i)
+  {
+    threads[i]->join();
+    delete threads[i];
+  }
+  lock.lock();
+}
+
+void WorkerPool::reapRetired()
+{
+  // exited workers are joined without waiting
+  for (std::size_t i = 0; i < retired_threads_.size();)
+  {
+    std::vector<boost::thread::id>::iterator exited =
+        std::find(exited_threads_.begin(), exited_threads_.end(), retired_threads_[i]->get_id());
+    if (exited == exited_threads_.end())
+    {
+      ++i;
+      continue;
+    }
+
+    exited_threads_.erase(exited);
+    retired_threads_[i]->join();
+    delete retired_threads_[i];
+    retired_threads_.erase(retired_threads_.begin() + i);
+  }
+}
+
+bool WorkerPool::isRetired(std::size_t worker) const
+{
+  // a later worker may have taken over the index
+  return worker >= threads_.size() || threads_[worker]->get_id() != boost::this_thread::get_id();
+}
+
+void WorkerPool::run(std::size_t worker)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+
+  while (true)
+  {
+    Queue* queue = NULL;
+    while (!stopping_ && !isRetired(worker) && !(queue = take(worker)))
+      work_.wait(lock);
+
+    // queued work is left to the workers started next
+    if (stopping_)
+      return;
+
+    if (isRetired(worker))
+    {
+      exited_threads_.push_back(boost::this_thread::get_id());
+      return;
+    }
+
+    Task task = queue->tasks_.front();
+    queue->tasks_.pop_front();
+    queue->scheduled_ = false;
+    queue->running_ = true;
+
+    lock.unlock();
+    try
+    {
+      task();
+    }
+    catch (std::exception& e)
+    {
+      ROS_ERROR("Octomap worker task failed: %s", e.what());
+    }
+    lock.lock();
+
+    queue->running_ = false;
+    if (!queue->tasks_.empty())
+      schedule(queue);
+    queue->idle_.notify_all();
+  }
+}
+
+} // namespace octomap_rviz_plugin
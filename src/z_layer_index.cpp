@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2026, the octomap_rviz_plugins contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "octomap_rviz_plugins/z_layer_index.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace octomap_rviz_plugin
+{
+
+ZLayerIndex::ZLayerIndex() :
+    min_z_(0.0),
+    layer_height_(1.0)
+{
+}
+
+int ZLayerIndex::layerOf(double z) const
+{
+  return static_cast<int>(std::floor((z - min_z_) / layer_height_));
+}
+
+void ZLayerIndex::build(const std::vector<rviz::PointCloud::Point>& points, double layer_height)
+{
+  layer_height_ = layer_height;
+
+  order_.resize(points.size());
+  layer_start_.clear();
+
+  if (points.empty())
+    return;
+
+  // layers are centered on the voxel centers, starting at the lowest voxel
+  float lowest = points[0].position.z;
+  for (std::size_t i = 1; i < points.size(); ++i)
+    lowest = std::min(lowest, points[i].position.z);
+  min_z_ = lowest - 0.5 * layer_height;
+
+  int num_layers = 0;
+  for (std::size_t i = 0; i < points.size(); ++i)
+    num_layers = std::max(num_layers, layerOf(points[i].position.z) + 1);
+
+  // count points per layer, then turn the counts into start offsets
+  layer_start_.assign(num_layers + 1, 0);
+  for (std::size_t i = 0; i < points.size(); ++i)
+    ++layer_start_[std::max(0, layerOf(points[i].position.z)) + 1];
+
+  for (int l = 0; l < num_layers; ++l)
+    layer_start_[l + 1] += layer_start_[l];
+
+  std::vector<uint32_t> fill(layer_start_.begin(), layer_start_.end() - 1);
+  for (std::size_t i = 0; i < points.size(); ++i)
+    order_[fill[std::max(0, layerOf(points[i].position.z))]++] = i;
+}
+
+void ZLayerIndex::clear()
+{
+  order_.clear();
+  layer_start_.clear();
+}
+
+void ZLayerIndex::select(const std::vector<rviz::PointCloud::Point>& points, double min_z, double max_z,
+                         std::vector<rviz::PointCloud::Point>& out) const
+{
+  if (layer_start_.empty() || max_z < min_z)
+    return;
+
+  int num_layers = layer_start_.size() - 1;
+  int first = std::max(0, layerOf(min_z));
+  int last = std::min(num_layers - 1, layerOf(max_z));
+
+  for (int l = first; l <= last; ++l)
+  {
+    for (uint32_t k = layer_start_[l]; k < layer_start_[l + 1]; ++k)
+    {
+      const rviz::PointCloud::Point& point = points[order_[k]];
+      if (point.position.z >= min_z && point.position.z <= max_z)
+        out.push_back(point);
+    }
+  }
+}
+
+std::size_t ZLayerIndex::memoryUsage() const
+{
+  return (order_.capacity() + layer_start_.capacity()) * sizeof(uint32_t);
+}
+
+void ZLayerIndex::swap(ZLayerIndex& other)
+{
+  std::swap(min_z_, other.min_z_);
+  std::swap(layer_height_, other.layer_height_);
+  order_.swap(other.order_);
+  layer_start_.swap(other.layer_start_);
+}
+
+} // namespace octomap_rviz_plugin